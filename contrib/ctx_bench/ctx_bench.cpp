@@ -0,0 +1,125 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ctx.h"
+#include "state.h"
+
+using namespace ethos;
+
+namespace {
+
+/**
+ * The operations performed on a substitution by matching and evaluation:
+ * add k entries, look each one up several times, and copy the result, as is
+ * done when a frame of evaluation is created.
+ */
+template <typename C>
+size_t run(const std::vector<ExprValue*>& keys,
+           const std::vector<ExprValue*>& vals,
+           size_t k,
+           size_t iters)
+{
+  size_t found = 0;
+  for (size_t it = 0; it < iters; it++)
+  {
+    C c;
+    for (size_t i = 0; i < k; i++)
+    {
+      c.emplace(keys[i], vals[i]);
+    }
+    for (size_t r = 0; r < 4; r++)
+    {
+      for (size_t i = 0; i < k; i++)
+      {
+        found += c.find(keys[(i + r) % k]) != c.end() ? 1 : 0;
+      }
+    }
+    C copy(c);
+    found += copy.size();
+  }
+  return found;
+}
+
+template <typename C>
+double timeRun(const std::vector<ExprValue*>& keys,
+               const std::vector<ExprValue*>& vals,
+               size_t k,
+               size_t iters,
+               size_t& found)
+{
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  found += run<C>(keys, vals, k, iters);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+}  // namespace
+
+/**
+ * Reports the time taken by std::map and Ctx for substitutions of various
+ * sizes, whose keys and values are parameters and constants of a state.
+ *
+ * Options:
+ *   --ops=N  the number of entries inserted per size (default 10000000)
+ */
+int main(int argc, char* argv[])
+{
+  size_t ops = 10000000;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 6, "--ops=") == 0)
+    {
+      ops = std::stoul(arg.substr(6));
+    }
+    else
+    {
+      std::cerr << "Usage: ctx-bench [--ops=N]" << std::endl;
+      return 1;
+    }
+  }
+  Options opts;
+  Stats stats;
+  State s(opts, stats);
+  Expr t = s.mkType();
+  const size_t maxSize = 64;
+  std::vector<Expr> terms;
+  std::vector<ExprValue*> keys;
+  std::vector<ExprValue*> vals;
+  for (size_t i = 0; i < maxSize; i++)
+  {
+    std::string si = std::to_string(i);
+    terms.push_back(s.mkSymbol(Kind::PARAM, "x" + si, t));
+    keys.push_back(terms.back().getValue());
+    terms.push_back(s.mkSymbol(Kind::CONST, "c" + si, t));
+    vals.push_back(terms.back().getValue());
+  }
+  size_t found = 0;
+  std::cout << std::fixed << std::setprecision(3);
+  for (size_t k : {2, 4, 8, 16, 32, 64})
+  {
+    size_t iters = ops / k;
+    double tm = timeRun<std::map<ExprValue*, ExprValue*>>(
+        keys, vals, k, iters, found);
+    double tc = timeRun<Ctx>(keys, vals, k, iters, found);
+    std::cout << "k=" << std::setw(2) << k << "  map " << tm << "s  ctx "
+              << tc << "s" << std::endl;
+  }
+  // ensure the lookups are not optimized away
+  return found == 0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "input.h"
+#include "lexer.h"
+
+using namespace ethos;
+
+/**
+ * Lexes the given files, and the .eo and .smt2 files in the given
+ * directories, and reports the number of tokens per second.
+ *
+ * Options:
+ *   --repeat=N  lex each file N times (default 10)
+ *   --stream    lex from an input stream rather than the file in memory
+ */
+int main(int argc, char* argv[])
+{
+  size_t repeat = 10;
+  bool stream = false;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 9, "--repeat=") == 0)
+    {
+      repeat = std::stoul(arg.substr(9));
+    }
+    else if (arg == "--stream")
+    {
+      stream = true;
+    }
+    else if (std::filesystem::is_directory(arg))
+    {
+      for (const std::filesystem::directory_entry& e :
+           std::filesystem::recursive_directory_iterator(arg))
+      {
+        std::string ext = e.path().extension().string();
+        if (e.is_regular_file() && (ext == ".eo" || ext == ".smt2"))
+        {
+          files.push_back(e.path().string());
+        }
+      }
+    }
+    else
+    {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty())
+  {
+    std::cerr << "Usage: lexer-bench [--repeat=N] [--stream] <file|dir>+"
+              << std::endl;
+    return 1;
+  }
+  Lexer lex(true);
+  size_t ntokens = 0;
+  size_t nbytes = 0;
+  std::chrono::duration<double> elapsed(0);
+  for (const std::string& f : files)
+  {
+    for (size_t r = 0; r < repeat; r++)
+    {
+      std::ifstream fs;
+      std::unique_ptr<Input> in;
+      if (stream)
+      {
+        fs.open(f, std::ios::binary);
+        in = Input::mkStreamInput(fs);
+      }
+      else
+      {
+        in = Input::mkFileInput(f);
+      }
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      lex.initialize(in.get(), f);
+      while (lex.nextToken() != Token::EOF_TOK)
+      {
+        ntokens++;
+      }
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+    nbytes += std::filesystem::file_size(f) * repeat;
+  }
+  double secs = elapsed.count();
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "files: " << files.size() << std::endl;
+  std::cout << "bytes: " << nbytes << std::endl;
+  std::cout << "tokens: " << ntokens << std::endl;
+  std::cout << "time: " << secs << "s" << std::endl;
+  std::cout << "tokens/s: " << std::setprecision(0) << (ntokens / secs)
+            << std::endl;
+  std::cout << "MB/s: " << std::setprecision(1) << (nbytes / secs / 1e6)
+            << std::endl;
+  return 0;
+}
@@ -6,11 +6,34 @@
 
 #include "base/check.h"
 #include "base/output.h"
+#include "executor.h"
 #include "state.h"
 #include "util/filesystem.h"
 
 namespace ethos {
 
+/** Escape s so that it can be written as a C++ string literal */
+static std::string escapeString(const std::string& s)
+{
+  std::stringstream ss;
+  for (char c : s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      ss << '\\' << c;
+    }
+    else if (c == '\n')
+    {
+      ss << "\\n";
+    }
+    else
+    {
+      ss << c;
+    }
+  }
+  return ss.str();
+}
+
 CompilerScope::CompilerScope(std::ostream& decl,
                              std::ostream& out,
                              const std::string& prefix,
@@ -70,26 +93,58 @@ size_t CompilerScope::allocateSubscope()
   return ret;
 }
 
-PathTrie::PathTrie(std::ostream& decl, const std::string& prefix) : d_decl(decl), d_prefix(prefix){}
+PathTrie::PathTrie(std::ostream& decl,
+                   const std::string& prefix,
+                   const std::string& root)
+    : d_decl(decl), d_prefix(prefix), d_root(root)
+{
+}
 
 std::string PathTrie::getNameForPath(const std::vector<size_t>& path)
 {
-  return d_trie.getNameForPath(d_decl, d_prefix, path);
+  return d_trie.getNameForPath(d_decl, d_prefix, d_root, path);
 }
 
-void PathTrie::markDeclared(const std::vector<size_t>& path)
+std::string PathTrie::getReferenceForPath(const std::vector<size_t>& path)
 {
+  Assert(!path.empty());
+  // if already declared, use its name
   PathTrieNode* pt = &d_trie;
-  size_t i = 0;
-  while (i<path.size())
+  std::stringstream cname;
+  cname << d_prefix;
+  for (size_t i : path)
   {
-    pt = &pt->d_children[path[i]];
-    i++;
+    std::map<size_t, PathTrieNode>::iterator it = pt->d_children.find(i);
+    if (it == pt->d_children.end() || !it->second.d_decl)
+    {
+      pt = nullptr;
+      break;
+    }
+    pt = &it->second;
+    cname << i;
+  }
+  if (pt != nullptr)
+  {
+    return cname.str();
+  }
+  // otherwise access it from its parent
+  std::stringstream ref;
+  if (path.size() == 1)
+  {
+    ref << d_root << "[" << path[0] << "]";
+  }
+  else
+  {
+    std::vector<size_t> ppath(path.begin(), path.end() - 1);
+    ref << "(*" << getNameForPath(ppath) << ")[" << path.back() << "]";
   }
-  pt->d_decl = true;
+  return ref.str();
 }
 
-std::string PathTrie::PathTrieNode::getNameForPath(std::ostream& osdecl, const std::string& prefix, const std::vector<size_t>& path)
+std::string PathTrie::PathTrieNode::getNameForPath(std::ostream& osdecl,
+                                                   const std::string& prefix,
+                                                   const std::string& root,
+                                                   const std::vector<size_t>& path)
 {
   PathTrieNode* pt = this;
   size_t i = 0;
@@ -102,13 +157,19 @@ std::string PathTrie::PathTrieNode::getNameForPath(std::ostream& osdecl, const s
     if (!pt->d_decl)
     {
       pt->d_decl = true;
-      osdecl << "  ExprValue* " << cname.str() << " = (*" << curr << ")["
-             << path[i] << "];" << std::endl;
+      osdecl << "  ExprValue* " << cname.str() << " = ";
+      if (i == 0)
+      {
+        osdecl << root << "[" << path[i] << "];" << std::endl;
+      }
+      else
+      {
+        osdecl << "(*" << curr << ")[" << path[i] << "];" << std::endl;
+      }
     }
     curr = cname.str();
     i++;
   }
-  while (i<path.size());
   return curr;
 }
 
@@ -116,28 +177,23 @@ std::string PathTrie::PathTrieNode::getNameForPath(std::ostream& osdecl, const s
 Compiler::Compiler(State& s) :
   d_state(s), d_nscopes(0), d_global(d_decl, d_init, "_e", nullptr)
 {
-  d_decl << "std::map<const ExprValue*, size_t> _runId;" << std::endl;
-  d_decl << "Ctx _ctxTmp;" << std::endl;
-  d_decl << "Expr _etmp;" << std::endl;
-  d_decl << "bool _btmp;" << std::endl;
-  d_decl << "bool _btmp2;" << std::endl;
-  d_decl << "const Literal* _ltmp;" << std::endl;
-  d_config << "std::string Executor::showCompiledFiles()" << std::endl;
+  d_decl << "  std::map<const ExprValue*, size_t> _runId;" << std::endl;
+  d_config << "std::string CompiledExecutor::showCompiledFiles()" << std::endl;
   d_config << "{" << std::endl;
   d_config << "  std::stringstream ss;" << std::endl;
   d_configEnd << "  return ss.str();" << std::endl;
   d_configEnd << "}" << std::endl;
-  d_init << "void Executor::initialize()" << std::endl;
+  d_init << "void CompiledExecutor::initialize()" << std::endl;
   d_init << "{" << std::endl;
   d_initEnd << "}" << std::endl;
-  d_tc << "Expr Executor::getType(ExprValue* hdType, const "
+  d_tc << "Expr CompiledExecutor::getType(ExprValue* hdType, const "
           "std::vector<ExprValue*>& args, std::ostream* out)"
        << std::endl;
   d_tc << "{" << std::endl;
   d_tc << "  std::map<const ExprValue*, size_t>::iterator itr = "
           "_runId.find(hdType);"
        << std::endl;
-  // ASSERT
+  d_tc << "  if (itr == _runId.end()) return d_null;" << std::endl;
   d_tc << "  switch(itr->second)" << std::endl;
   d_tc << "  {" << std::endl;
   d_tcEnd << "  default: break;" << std::endl;
@@ -145,28 +201,27 @@ Compiler::Compiler(State& s) :
   // TODO: write error?
   d_tcEnd << "  return d_null;" << std::endl;
   d_tcEnd << "}" << std::endl;
-  d_eval << "Expr Executor::evaluate(ExprValue* e, Ctx& ctx)"
+  d_eval << "Expr CompiledExecutor::evaluate(ExprValue* e, Ctx& ctx)"
          << std::endl;
   d_eval << "{" << std::endl;
-  d_eval << "  Ctx::iterator itc;" << std::endl;
   d_eval
       << "  std::map<const ExprValue*, size_t>::iterator itr = _runId.find(e);"
       << std::endl;
-  // ASSERT
+  d_eval << "  if (itr == _runId.end()) return d_null;" << std::endl;
   d_eval << "  switch(itr->second)" << std::endl;
   d_eval << "  {" << std::endl;
   d_evalEnd << "  default: break;" << std::endl;
   d_evalEnd << "  }" << std::endl;
   d_evalEnd << "  return d_null;" << std::endl;
   d_evalEnd << "}" << std::endl;
-  d_evalp << "ExprValue* Executor::evaluateProgramInternal(const "
+  d_evalp << "ExprValue* CompiledExecutor::evaluateProgramInternal(const "
              "std::vector<ExprValue*>& args, Ctx& ctx)"
           << std::endl;
   d_evalp << "{" << std::endl;
   d_evalp << "  std::map<const ExprValue*, size_t>::iterator itr = "
              "_runId.find(args[0]);"
           << std::endl;
-  // ASSERT
+  d_evalp << "  if (itr == _runId.end()) return nullptr;" << std::endl;
   d_evalp << "  switch(itr->second)" << std::endl;
   d_evalp << "  {" << std::endl;
   d_evalpEnd << "  default: break;" << std::endl;
@@ -200,7 +255,8 @@ void Compiler::setLiteralTypeRule(Kind k, const Expr& t)
     return;
   }
   size_t id = writeGlobalExpr(t);
-  d_init << "  d_tc.setLiteralTypeRule(Kind::" << k << ", _e" << id << ");" << std::endl;
+  d_init << "  d_state.setLiteralTypeRule(Kind::" << k << ", _e" << id << ");"
+         << std::endl;
 }
 
 void Compiler::includeFile(const Filepath& s, bool isReference, const Expr& referenceNf)
@@ -210,8 +266,10 @@ void Compiler::includeFile(const Filepath& s, bool isReference, const Expr& refe
     EO_FATAL() << "Compiler::includeFile: cannot use reference when compiling";
   }
   Assert (d_nscopes==0);
-  d_init << "  d_state.markIncluded(\"" << s.getRawPath() << "\");" << std::endl;
-  d_config << "  ss << std::setw(15) << \" \" << \"" << s.getRawPath()
+  d_files.push_back(s.getRawPath());
+  std::string path = escapeString(s.getRawPath());
+  d_init << "  markIncluded(\"" << path << "\");" << std::endl;
+  d_config << "  ss << std::setw(15) << \" \" << \"" << path
            << "\" << std::endl;" << std::endl;
 }
 
@@ -224,7 +282,8 @@ void Compiler::bind(const std::string& name, const Expr& e)
   // write the code for constructing the expression
   size_t id = writeGlobalExpr(e);
   // bind the symbol
-  d_init << "  d_state.bind(\"" << name << "\", _e" << id << ");" << std::endl;
+  d_init << "  d_state.bind(\"" << escapeString(name) << "\", _e" << id << ");"
+         << std::endl;
   // write its type checker (if necessary)
   ExprValue* t = d_state.lookupType(e.getValue());
   if (t != nullptr)
@@ -236,17 +295,22 @@ void Compiler::bind(const std::string& name, const Expr& e)
 
 void Compiler::markConstructorKind(const Expr& v, Attr a, const Expr& cons)
 {
-  if (d_nscopes>0)
+  // programs are marked when their definition is replayed, see defineProgram
+  if (d_nscopes>0 || a == Attr::PROGRAM)
   {
     return;
   }
+  if (a == Attr::ORACLE)
+  {
+    EO_FATAL() << "Compiler::markConstructorKind: cannot compile oracles";
+  }
   size_t id = writeGlobalExpr(v);
   size_t idc = 0;
   if (!cons.isNull())
   {
     idc = writeGlobalExpr(cons);
   }
-  d_init << "  markConstructorKind(_e" << id << ", Attr::" << a << ", ";
+  d_init << "  d_state.markConstructorKind(_e" << id << ", Attr::" << a << ", ";
   if (cons.isNull())
   {
     d_init << "d_null";
@@ -276,6 +340,12 @@ void Compiler::defineProgram(const Expr& v, const Expr& prog)
     
   // write evaluation for subterms of each case
   size_t ncases = prog.getNumChildren();
+  if (ncases > 0)
+  {
+    // applications with the wrong number of arguments do not evaluate
+    os << "     if (args.size()!=" << prog[0][0].getNumChildren()
+       << ") return nullptr;" << std::endl;
+  }
   os << "     size_t _i=0;" << std::endl;
   os << "     while (_i<" << ncases << ")" << std::endl;
   os << "     {" << std::endl;
@@ -298,13 +368,10 @@ void Compiler::defineProgram(const Expr& v, const Expr& prog)
     std::stringstream decl;
     std::vector<std::string> reqs;
     std::map<const ExprValue*, std::string> varAssign;
-    PathTrie pt(decl, "a");
+    PathTrie pt(decl, "a", "args");
     for (size_t j = 1, nchild = hd.getNumChildren(); j < nchild; j++)
     {
       std::vector<size_t> initPath{j};
-      std::stringstream ssa;
-      decl << "  ExprValue* a" << j << " = args[" << j << "];" << std::endl;
-      pt.markDeclared(initPath);
       // write matching code
       writeMatching(hd[j], initPath, pt, reqs, varAssign, "break");
     }
@@ -340,6 +407,10 @@ void Compiler::defineProgram(const Expr& v, const Expr& prog)
   os << "       }" << std::endl;
   os << "     }" << std::endl;
   os << osEnd.str();
+  // replay the definition, so that the program is known to the state
+  size_t pid = writeGlobalExpr(prog);
+  d_init << "  d_state.defineProgram(_e" << id << ", _e" << pid << ");"
+         << std::endl;
 }
 
 void Compiler::finalize()
@@ -422,6 +493,7 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
       // allocate an identifier
       ret = cs.ensureDeclared(cur);
       std::ostream& os = cs.d_out;
+      tid = 0;
       if (isg)
       {
         // If global, write its type as well, separately. The recursion depth here is very limited.
@@ -439,7 +511,7 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
         Assert(curLit != nullptr);
         os << "  " << cs.d_prefix << ret << " = ";
         os << "d_state.mkLiteral(Kind::" << cur.getKind() << ", \""
-           << curLit->toString() << "\");" << std::endl;
+           << escapeString(curLit->toString()) << "\");" << std::endl;
       }
       else if (isSymbol(ck))
       {
@@ -447,15 +519,43 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
         curLit = cv->asLiteral();
         Assert(curLit != nullptr);
         os << "  " << cs.d_prefix << ret << " = ";
-        // special case: d_self
+        std::string name = escapeString(curLit->toString());
+        std::stringstream type;
+        if (tid == 0)
+        {
+          type << "d_null";
+        }
+        else
+        {
+          type << "_e" << tid;
+        }
+        // special cases: symbols that are constructed by the state, and
+        // variables in binders, which are unique for their name and type
         if (cur == d_state.mkSelf())
         {
           os << "d_state.mkSelf();" << std::endl;
         }
+        else if (cur == d_state.mkConclusion())
+        {
+          os << "d_state.mkConclusion();" << std::endl;
+        }
+        else if (curLit->toString().compare(0, 4, "eo::") == 0
+                 && d_state.getVar(curLit->toString()) == cur)
+        {
+          os << "d_state.getVar(\"" << name << "\");" << std::endl;
+        }
+        else if (ck == Kind::VARIABLE && tid != 0
+                 && d_state.getBoundVar(curLit->toString(),
+                                        Expr(d_state.lookupType(cv)))
+                        == cur)
+        {
+          os << "d_state.getBoundVar(\"" << name << "\", " << type.str()
+             << ");" << std::endl;
+        }
         else
         {
-          os << "d_state.mkSymbol(Kind::" << cur.getKind() << ", \""
-             << curLit->toString() << "\", _e" << tid << ");" << std::endl;
+          os << "d_state.mkSymbol(Kind::" << cur.getKind() << ", \"" << name
+             << "\", " << type.str() << ");" << std::endl;
         }
       }
       else if (ck==Kind::TYPE)
@@ -466,19 +566,21 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
       {
         os << "  " << cs.d_prefix << ret << " = d_state.mkBoolType();" << std::endl;
       }
-      else if (ck==Kind::NULL_EXPR)
-      {
-        os << "  " << cs.d_prefix << ret << " = d_state.mkNil();" << std::endl;
-      }
       else if (ck==Kind::EVAL_IF_THEN_ELSE && cs.d_progEval)
       {
         // we have only written the condition
         Expr condc = cur[0];
         std::string cond = s.getNameFor(condc);
-        os << "  _ltmp = " << cond << ".getValue()->asLiteral();"
-           << std::endl;
-        os << "  _btmp = (_ltmp!=nullptr && _ltmp->getKind()==Kind::BOOLEAN);" << std::endl;
-        os << "  _btmp2 = (_btmp && _ltmp->d_bool);" << std::endl;
+        // whether the condition is a Boolean value, and whether it is true,
+        // which are named uniquely since branches may contain other ite terms
+        std::stringstream ssb;
+        ssb << cs.d_prefix << ret << "_b";
+        std::string isBool = ssb.str();
+        std::string isTrue = isBool + "t";
+        os << "  bool " << isBool << " = (" << cond
+           << ".getKind()==Kind::BOOLEAN);" << std::endl;
+        os << "  bool " << isTrue << " = (" << isBool << " && " << cond
+           << ".getValue()->asLiteral()->d_bool);" << std::endl;
         std::stringstream osite;
         std::vector<std::string> branches;
         for (size_t i=0; i<2; i++)
@@ -496,7 +598,8 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
           // generated, for branches that share subterms. We should factor
           // out common subterms from the branches here.
           // determine if we should compute this branch
-          osite << "  if (!_btmp || " << (i==1 ? "!" : "") << "_btmp2)" << std::endl;
+          osite << "  if (!" << isBool << " || " << (i == 1 ? "!" : "")
+                << isTrue << ")" << std::endl;
           osite << "  {" << std::endl;
           // write the expression in a local scope
           std::stringstream localDecl;
@@ -520,29 +623,19 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
         }
         os << osite.str();
         // put together the result
-        os << "  if (!_btmp)" << std::endl;
+        os << "  if (!" << isBool << ")" << std::endl;
         os << "  {" << std::endl;
         os << "    " << cs.d_prefix << ret << " = Expr(";
-        os << "d_state.";
         os << "mkExprInternal(Kind::EVAL_IF_THEN_ELSE, {" << cond
            << ".getValue(), " << branches[0] << ".getValue(), " << branches[1]
            << ".getValue()}));" << std::endl;
         os << "  }" << std::endl;
         os << "  else" << std::endl;
         os << "  {" << std::endl;
-        os << "    " << cs.d_prefix << ret << " = _btmp2 ? " << branches[0] << " : " << branches[1] << ";" << std::endl;
+        os << "    " << cs.d_prefix << ret << " = " << isTrue << " ? "
+           << branches[0] << " : " << branches[1] << ";" << std::endl;
         os << "  }" << std::endl;
       }
-      else if (ck==Kind::EVAL_REQUIRES && cs.d_progEval)
-      {
-        // call mkRequiresType, which simplifies
-        std::string a1 = s.getNameFor(cur[0]);
-        std::string a2 = s.getNameFor(cur[1]);
-        std::string a3 = s.getNameFor(cur[2]);
-        os << "    " << cs.d_prefix << ret << " = ";
-        os << "d_state.";
-        os << "mkRequires(" << a1 << ", " << a2 << ", " << a3 << ");" << std::endl;
-      }
       else
       {
         std::stringstream argList;
@@ -565,12 +658,18 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
             Kind hk = cur[0].getKind();
             if (hk==Kind::PROGRAM_CONST || hk==Kind::ORACLE)
             {
-              // we should just evaluate it if the scope specifies it should be evaluated
-              os << "  _ctxTmp.clear();" << std::endl;
-              os << "  _etmp = d_tc.evaluateProgram(" << argList.str()
-                << ", _ctxTmp);" << std::endl;
-              os << "  " << cs.d_prefix << ret
-                << " = evaluate(_etmp.getValue(), _ctxTmp);" << std::endl;
+              // we should just evaluate it if the scope specifies it should
+              // be evaluated, where as in TypeChecker::evaluate, the body is
+              // not evaluated if it is ground or the context is empty
+              os << "  {" << std::endl;
+              os << "    Ctx _ctx;" << std::endl;
+              os << "    Expr _body = d_tc.evaluateProgram(" << argList.str()
+                 << ", _ctx);" << std::endl;
+              os << "    " << cs.d_prefix << ret
+                 << " = (_body.isGround() || _ctx.empty()) ? _body : "
+                    "d_tc.evaluate(_body.getValue(), _ctx);"
+                 << std::endl;
+              os << "  }" << std::endl;
               wroteExpr = true;
             }
           }
@@ -586,7 +685,6 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
         if (!wroteExpr)
         {
           os << "  " << cs.d_prefix << ret << " = Expr(";
-          os << "d_state.";
           os << "mkExprInternal(Kind::" << cur.getKind() << ", "
              << argList.str() << "));" << std::endl;
           if (isg)
@@ -595,9 +693,10 @@ size_t Compiler::writeExprInternal(const Expr& e, CompilerScope& s)
             ExprValue* t = d_state.lookupType(cur.getValue());
             if (t != nullptr)
             {
-              os << "  d_state.d_typeCache[" << d_global.d_prefix << ret
-                 << ".getValue()] = " << d_global.d_prefix << tid << ";"
-                 << std::endl;
+              os << "  if (d_state.lookupType(" << d_global.d_prefix << ret
+                 << ".getValue())==nullptr) setType("
+                 << d_global.d_prefix << ret << ".getValue(), "
+                 << d_global.d_prefix << tid << ".getValue());" << std::endl;
             }
           }
         }
@@ -630,6 +729,18 @@ void Compiler::writeTypeChecking(std::ostream& os, const Expr& t)
       // already written
       continue;
     }
+    // the argument types that are evaluatable are evaluated in the context of
+    // the previous arguments before matching, which is left to the type
+    // checker
+    bool hasEvalArg = false;
+    for (size_t i = 0, nargs = curr.getNumChildren() - 1; i < nargs; i++)
+    {
+      hasEvalArg = hasEvalArg || curr[i].isEvaluatable();
+    }
+    if (hasEvalArg)
+    {
+      continue;
+    }
     os << "  // type rule for " << curr << std::endl;
     Trace("compiler") << "writeTypeChecking " << curr << std::endl;
     d_tcWritten.insert(cv);
@@ -653,7 +764,7 @@ void Compiler::writeTypeChecking(std::ostream& os, const Expr& t)
     // write the matching
     std::vector<std::string> reqs;
     std::map<const ExprValue*, std::string> varAssign;
-    PathTrie pt(pscope.d_decl, "a");
+    PathTrie pt(pscope.d_decl, "a", "args");
     for (size_t i = 0, nargs = curr.getNumChildren() - 1; i < nargs; i++)
     {
       Expr pat = curr[i];
@@ -662,11 +773,8 @@ void Compiler::writeTypeChecking(std::ostream& os, const Expr& t)
       {
         pat = pat[0];
       }
-      pscope.d_decl << "  ExprValue* a" << i << " = args[" << i << "];"
-                    << std::endl;
       // write matching code for args[i] against the type argument pat
       std::vector<size_t> initPath{i};
-      pt.markDeclared(initPath);
       writeMatching(pat, initPath, pt, reqs, varAssign, "return d_null");
     }
     if (!reqs.empty())
@@ -711,6 +819,8 @@ void Compiler::writeTypeChecking(std::ostream& os, const Expr& t)
     }
     // TODO: optimization: if free variables only occur in requires conditions,
     // we can set usedMatch to false
+    // the return type must be evaluated if it is evaluatable
+    usedMatch = usedMatch || retType.isEvaluatable();
 
     std::string ret;
     localImpl << "  // construct return type" << std::endl;
@@ -756,10 +866,12 @@ void Compiler::writeMatching(const Expr& pat,
   {
     curr = toVisit.back();
     toVisit.pop_back();
-    std::string cterm = pt.getNameForPath(curr.first);
     const Expr& p = curr.second;
     if (p.getKind() == Kind::PARAM)
     {
+      // the term is referenced at most once here, and does not need a
+      // variable
+      std::string cterm = pt.getReferenceForPath(curr.first);
       const ExprValue* pv = p.getValue();
       // if we haven't visited yet
       itv = varAssign.find(pv);
@@ -779,6 +891,7 @@ void Compiler::writeMatching(const Expr& pat,
     }
     else if (p.isGround())
     {
+      std::string cterm = pt.getReferenceForPath(curr.first);
       // just check equality
       size_t id = writeGlobalExpr(p);
       std::stringstream ssg;
@@ -787,6 +900,7 @@ void Compiler::writeMatching(const Expr& pat,
       // nothing else is required
       continue;
     }
+    std::string cterm = pt.getNameForPath(curr.first);
     // requires matching kind/number of children
     std::stringstream ssk;
     ssk << cterm << "->getKind()==Kind::" << p.getKind();
@@ -862,6 +976,10 @@ void Compiler::writeEvaluate(std::ostream& os, const Expr& e)
     CompilerScope pscope(localDecl, localImpl, pprefix, &d_global, true);
     std::vector<Expr> fvs = Expr::getVariables(curr);
     std::map<const ExprValue*, size_t>::iterator iti;
+    if (!fvs.empty())
+    {
+      localDecl << "  Ctx::iterator itc;" << std::endl;
+    }
     for (const Expr& v : fvs)
     {
       pscope.ensureDeclared(v);
@@ -890,14 +1008,33 @@ void Compiler::writeEvaluate(std::ostream& os, const Expr& e)
 std::string Compiler::toString()
 {
   std::stringstream ss;
+  ss << "#include <iomanip>" << std::endl;
+  ss << std::endl;
   ss << "#include \"executor.h\"" << std::endl;
   ss << "#include \"state.h\"" << std::endl;
   ss << "#include \"type_checker.h\"" << std::endl;
-  ss << "#include <iomanip>" << std::endl;
   ss << std::endl;
   ss << "namespace ethos {" << std::endl;
   ss << std::endl;
-  ss << d_decl.str() << std::endl;
+  ss << "class CompiledExecutor : public Executor" << std::endl;
+  ss << "{" << std::endl;
+  ss << " public:" << std::endl;
+  ss << "  CompiledExecutor(State& s) : Executor(s) {}" << std::endl;
+  ss << "  std::string showCompiledFiles() override;" << std::endl;
+  ss << "  void initialize() override;" << std::endl;
+  ss << "  Expr getType(ExprValue* hdType, const std::vector<ExprValue*>& "
+        "args, std::ostream* out) override;"
+     << std::endl;
+  ss << "  Expr evaluate(ExprValue* e, Ctx& ctx) override;" << std::endl;
+  ss << " protected:" << std::endl;
+  ss << "  ExprValue* evaluateProgramInternal(const std::vector<ExprValue*>& "
+        "args, Ctx& ctx) override;"
+     << std::endl;
+  ss << " private:" << std::endl;
+  // the terms are members, so that they are released with the executor
+  ss << d_decl.str();
+  ss << "};" << std::endl;
+  ss << std::endl;
   ss << d_config.str();
   ss << d_configEnd.str() << std::endl;
   ss << d_init.str();
@@ -908,6 +1045,19 @@ std::string Compiler::toString()
   ss << d_evalEnd.str() << std::endl;
   ss << d_evalp.str();
   ss << d_evalpEnd.str() << std::endl;
+  ss << "}  // namespace ethos" << std::endl;
+  ss << std::endl;
+  // the entry points used by Executor::load
+  ss << "extern \"C\" const char* ethos_compiled_fingerprint()" << std::endl;
+  ss << "{" << std::endl;
+  ss << "  return \"" << escapeString(Executor::getFingerprint(d_files))
+     << "\";" << std::endl;
+  ss << "}" << std::endl;
+  ss << std::endl;
+  ss << "extern \"C\" ethos::Executor* ethos_mk_executor(ethos::State& s)"
+     << std::endl;
+  ss << "{" << std::endl;
+  ss << "  return new ethos::CompiledExecutor(s);" << std::endl;
   ss << "}" << std::endl;
   return ss.str();
 }
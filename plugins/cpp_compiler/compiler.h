@@ -83,14 +83,16 @@ public:
 
 /**
  * Maintains path accesses to an expression given by name prefix.
- * In particular, this will write accesses e.g. for prefix "a":
- *   Expr& a2 = a->getChildren()[2];
- *   Expr& a3 = a->getChildren()[3];
- *   Expr& a31 = a3->getChildren()[1];
- *   Expr& a30 = a3->getChildren()[0];
- *   Expr& a301 = a30->getChildren()[1];
- *   Expr& a300 = a30->getChildren()[0];
- * to the given declaration stream.
+ * In particular, this will write accesses e.g. for prefix "a" and root
+ * "args":
+ *   ExprValue* a2 = args[2];
+ *   ExprValue* a3 = args[3];
+ *   ExprValue* a31 = (*a3)[1];
+ *   ExprValue* a30 = (*a3)[0];
+ *   ExprValue* a301 = (*a30)[1];
+ *   ExprValue* a300 = (*a30)[0];
+ * to the given declaration stream, where each access is written when it is
+ * first required.
  */
 class PathTrie
 {
@@ -98,16 +100,30 @@ public:
   /**
    * @param decl The declaration stream
    * @param prefix The prefix for naming variables
+   * @param root The name of the vector of terms the paths start from
+   */
+  PathTrie(std::ostream& decl,
+           const std::string& prefix,
+           const std::string& root);
+  /**
+   * Get the name of the variable for path, declaring it and the variables
+   * for its prefixes if not already done.
    */
-  PathTrie(std::ostream& decl, const std::string& prefix);
   std::string getNameForPath(const std::vector<size_t>& path);
+  /**
+   * Get an expression for the term at path. This is the name of its variable
+   * if it has been declared, or otherwise an access of the variable for its
+   * parent, so that terms which are referenced at most once do not require
+   * a variable.
+   */
+  std::string getReferenceForPath(const std::vector<size_t>& path);
   /** The stream for declarations */
   std::ostream& d_decl;
-  /** mark that the given path should be declared */
-  void markDeclared(const std::vector<size_t>& path);
 private:
   /** The prefix */
   std::string d_prefix;
+  /** The root */
+  std::string d_root;
   class PathTrieNode
   {
   public:
@@ -122,6 +138,7 @@ private:
      */
     std::string getNameForPath(std::ostream& osdecl,
                                const std::string& prefix,
+                               const std::string& root,
                                const std::vector<size_t>& path);
   };
   /** Trie for managing declarations */
@@ -195,6 +212,8 @@ private:
    * Uses the same identifiers as in d_idMap.
    */
   std::map<const ExprValue*, size_t> d_runIdMap;
+  /** The files that were included, in order */
+  std::vector<std::string> d_files;
   /** */
   std::unordered_set<const ExprValue*> d_tcWritten;
   std::unordered_set<const ExprValue*> d_evalWritten;
@@ -8,14 +8,83 @@
  ******************************************************************************/
 
 #include "executor.h"
+
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+#include "base/output.h"
 #include "state.h"
 
 namespace ethos {
-  
+
 Executor::Executor(State& s) : d_state(s), d_tc(s.getTypeChecker()) {}
 
 Executor::~Executor() {}
-  
+
+Executor* Executor::load(State& s, const std::string& path)
+{
+  void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr)
+  {
+    EO_FATAL() << "Error: cannot load compiled signature " << path << ": "
+               << dlerror();
+  }
+  typedef const char* (*FingerprintFn)();
+  typedef Executor* (*MkExecutorFn)(State&);
+  FingerprintFn fp = reinterpret_cast<FingerprintFn>(
+      dlsym(handle, "ethos_compiled_fingerprint"));
+  MkExecutorFn mk =
+      reinterpret_cast<MkExecutorFn>(dlsym(handle, "ethos_mk_executor"));
+  if (fp == nullptr || mk == nullptr)
+  {
+    EO_FATAL() << "Error: " << path
+               << " is not a compiled signature generated by --gen-compile";
+  }
+  // the fingerprint lists the signature files, which are rechecked here
+  std::stringstream ss(fp());
+  std::string line;
+  std::vector<std::string> files;
+  while (std::getline(ss, line))
+  {
+    files.push_back(line.substr(0, line.rfind(' ')));
+  }
+  if (getFingerprint(files) != fp())
+  {
+    EO_FATAL() << "Error: the compiled signature " << path
+               << " is out of date with respect to the files it was generated "
+                  "from, rerun --gen-compile";
+  }
+  // the handle is never closed, since the executor is used until exit
+  return mk(s);
+}
+
+std::string Executor::getFingerprint(const std::vector<std::string>& files)
+{
+  std::stringstream ss;
+  for (const std::string& f : files)
+  {
+    // 64-bit FNV-1a hash of the contents of the file
+    uint64_t h = 14695981039346656037ULL;
+    std::ifstream in(f, std::ios::binary);
+    char buf[4096];
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+    {
+      for (std::streamsize i = 0, n = in.gcount(); i < n; i++)
+      {
+        h = (h ^ static_cast<unsigned char>(buf[i])) * 1099511628211ULL;
+      }
+    }
+    ss << f << " " << std::hex << std::setw(16) << std::setfill('0') << h
+       << std::dec << std::endl;
+  }
+  return ss.str();
+}
+
+std::string Executor::showCompiledFiles() { return ""; }
+
 bool Executor::hasEvaluation(ExprValue* e)
 {
   return e->isCompiled();
@@ -33,4 +102,23 @@ Expr Executor::evaluateProgram(ExprValue* prog,
   return Expr(ev);
 }
 
+ExprValue* Executor::mkExprInternal(Kind k,
+                                    const std::vector<ExprValue*>& children)
+{
+  return d_state.mkExprInternal(k, children);
+}
+
+void Executor::setType(ExprValue* e, ExprValue* t) { d_state.setType(e, t); }
+
+void Executor::markIncluded(const std::string& file)
+{
+  d_state.markIncluded(Filepath(file).getRealPath());
+}
+
+ExprValue* Executor::evaluateProgramInternal(
+    const std::vector<ExprValue*>& args, Ctx& ctx)
+{
+  return nullptr;
+}
+
 }
@@ -14,45 +14,64 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "plugin.h"
 
 namespace ethos {
 
+class State;
+class TypeChecker;
+
 /**
  * The executor class, which calls compiled C++ code generated by the compiler
  * plugin for more efficient execution of type checking and side condition
  * evaluation.
+ *
+ * The generated code defines a subclass of this class, which is built into a
+ * shared object and loaded at runtime via load below. The shared object
+ * provides the following entry points:
+ *   const char* ethos_compiled_fingerprint();
+ *   ethos::Executor* ethos_mk_executor(ethos::State& s);
+ * where the former returns the fingerprint of the signature files it was
+ * generated from, as given by getFingerprint.
  */
 class Executor : public Plugin
 {
   friend class TypeChecker;
 public:
   Executor(State& s);
-  ~Executor();
+  virtual ~Executor();
+  /**
+   * Load the compiled signature from the shared object at path. This fails
+   * with an error if the object cannot be loaded, or if one of the signature
+   * files it was generated from has changed since.
+   */
+  static Executor* load(State& s, const std::string& path);
+  /**
+   * Get the fingerprint of the given files, which has one line per file
+   * consisting of its path and a hash of its contents.
+   */
+  static std::string getFingerprint(const std::vector<std::string>& files);
   /** Print compiled files (for --show-config) */
-  static std::string showCompiledFiles();
-  /** Initialize. */
-  void initialize() override;
+  virtual std::string showCompiledFiles();
   /** Has evaluation. */
   bool hasEvaluation(ExprValue* e) override;
-  /** Get type. */
-  Expr getType(ExprValue* hdType,
-               const std::vector<ExprValue*>& args,
-               std::ostream* out) override;
-  /** Evaluate. */
-  Expr evaluate(ExprValue* e, Ctx& ctx) override;
   /** Evaluate program */
   Expr evaluateProgram(ExprValue* prog, const std::vector<ExprValue*>& args, Ctx& ctx) override;
-private:
+protected:
+  /** Calls the corresponding private methods of the state */
+  ExprValue* mkExprInternal(Kind k, const std::vector<ExprValue*>& children);
+  void setType(ExprValue* e, ExprValue* t);
+  void markIncluded(const std::string& file);
+  /** Compiled version */
+  virtual ExprValue* evaluateProgramInternal(const std::vector<ExprValue*>& args, Ctx& ctx);
   /** Reference to the state */
   State& d_state;
   /** Reference to the type checker */
   TypeChecker& d_tc;
   /** The null expression */
   Expr d_null;
-  /** Compiled version */
-  ExprValue* evaluateProgramInternal(const std::vector<ExprValue*>& args, Ctx& ctx);
 };
 
 }  // namespace ethos
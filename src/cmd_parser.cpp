@@ -18,6 +18,7 @@
 #include <iostream>
 #include <ostream>
 #include "base/output.h"
+#include "keywords.h"
 
 namespace ethos {
 
@@ -28,52 +29,6 @@ CmdParser::CmdParser(Lexer& lex,
     : d_lex(lex), d_state(state), d_sts(state.getStats()),
       d_eparser(eparser), d_isReference(isReference), d_isFinished(false)
 {
-  // initialize the command tokens
-  // commands supported in both inputs and proofs
-  d_table["declare-codatatype"] = Token::DECLARE_CODATATYPE;    // undocumented, TODO: remove
-  d_table["declare-codatatypes"] = Token::DECLARE_CODATATYPES;  // undocumented, TODO: remove
-  d_table["declare-const"] = Token::DECLARE_CONST;
-  d_table["declare-datatype"] = Token::DECLARE_DATATYPE;
-  d_table["declare-datatypes"] = Token::DECLARE_DATATYPES;
-  d_table["echo"] = Token::ECHO;
-  d_table["exit"] = Token::EXIT;
-  d_table["set-option"] = Token::SET_OPTION;
-  d_table["pop"] = Token::POP;    // undocumented
-  d_table["push"] = Token::PUSH;  // undocumented
-  d_table["reset"] = Token::RESET;
-
-  if (d_isReference)
-  {
-    // only used in smt2 queries
-    d_table["assert"] = Token::ASSERT;
-    d_table["declare-fun"] = Token::DECLARE_FUN;
-    d_table["declare-sort"] = Token::DECLARE_SORT;
-    d_table["define-const"] = Token::DEFINE_CONST;
-    d_table["define-fun"] = Token::DEFINE_FUN;
-    d_table["define-sort"] = Token::DEFINE_SORT;
-    d_table["check-sat"] = Token::CHECK_SAT;
-    d_table["check-sat-assuming"] = Token::CHECK_SAT_ASSUMING;
-    d_table["set-logic"] = Token::SET_LOGIC;
-    d_table["set-info"] = Token::SET_INFO;
-  }
-  else
-  {
-    d_table["assume"] = Token::ASSUME;
-    d_table["assume-push"] = Token::ASSUME_PUSH;
-    d_table["declare-consts"] = Token::DECLARE_CONSTS;
-    d_table["declare-oracle-fun"] = Token::DECLARE_ORACLE_FUN;
-    d_table["declare-parameterized-const"] = Token::DECLARE_PARAMETERIZED_CONST;
-    d_table["declare-rule"] = Token::DECLARE_RULE;
-    d_table["declare-type"] = Token::DECLARE_TYPE;
-    d_table["define"] = Token::DEFINE;
-    d_table["define-type"] = Token::DEFINE_TYPE;
-    d_table["include"] = Token::INCLUDE;
-    d_table["program"] = Token::PROGRAM;
-    d_table["reference"] = Token::REFERENCE;
-    d_table["step"] = Token::STEP;
-    d_table["step-pop"] = Token::STEP_POP;
-  }
-  
   d_statsEnabled = d_state.getOptions().d_stats;
 }
 
@@ -83,11 +38,14 @@ Token CmdParser::nextCommandToken()
   // symbols as commands
   if (tok == Token::SYMBOL)
   {
-    std::string str(d_lex.tokenStr());
-    std::map<std::string, Token>::iterator it = d_table.find(str);
-    if (it != d_table.end())
+    const Keyword* k = Keyword::find(d_lex.tokenView());
+    if (k != nullptr
+        && (k->d_category == Keyword::Category::COMMAND
+            || k->d_category
+                   == (d_isReference ? Keyword::Category::COMMAND_REFERENCE
+                                     : Keyword::Category::COMMAND_EO)))
     {
-      return it->second;
+      return k->d_token;
     }
   }
   return tok;
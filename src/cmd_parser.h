@@ -44,8 +44,6 @@ class CmdParser
   Stats& d_sts;
   /** The term parser */
   ExprParser& d_eparser;
-  /** Map strings to tokens */
-  std::map<std::string, Token> d_table;
   /** */
   bool d_isReference;
   /** Is finished */
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "ctx.h"
+
+#include <algorithm>
+
+#include "expr.h"
+
+namespace ethos {
+
+Ctx::Ctx() : d_data(d_inline), d_size(0) {}
+
+Ctx::Ctx(const Ctx& c) : d_data(d_inline), d_size(0) { copyFrom(c); }
+
+Ctx::Ctx(Ctx&& c) : d_data(d_inline), d_size(0) { moveFrom(c); }
+
+Ctx::~Ctx() {}
+
+Ctx& Ctx::operator=(const Ctx& c)
+{
+  if (this != &c)
+  {
+    clear();
+    copyFrom(c);
+  }
+  return *this;
+}
+
+Ctx& Ctx::operator=(Ctx&& c)
+{
+  if (this != &c)
+  {
+    clear();
+    moveFrom(c);
+  }
+  return *this;
+}
+
+void Ctx::copyFrom(const Ctx& c)
+{
+  if (c.d_size <= s_inlineSize)
+  {
+    std::copy(c.d_data, c.d_data + c.d_size, d_inline);
+  }
+  else
+  {
+    d_heap.assign(c.d_data, c.d_data + c.d_size);
+    d_data = d_heap.data();
+    d_index = c.d_index;
+  }
+  d_size = c.d_size;
+  d_keep = c.d_keep;
+}
+
+void Ctx::moveFrom(Ctx& c)
+{
+  if (c.d_data == c.d_inline)
+  {
+    std::copy(c.d_data, c.d_data + c.d_size, d_inline);
+  }
+  else
+  {
+    d_heap.swap(c.d_heap);
+    d_data = d_heap.data();
+    d_index.swap(c.d_index);
+  }
+  d_size = c.d_size;
+  d_keep.swap(c.d_keep);
+  c.clear();
+}
+
+Ctx::const_iterator Ctx::findHashed(const ExprValue* key) const
+{
+  std::unordered_map<const ExprValue*, size_t>::const_iterator it =
+      d_index.find(key);
+  return it == d_index.end() ? cend() : d_data + it->second;
+}
+
+std::pair<Ctx::iterator, bool> Ctx::emplace(ExprValue* key, ExprValue* val)
+{
+  iterator it = find(key);
+  if (it != end())
+  {
+    return std::pair<iterator, bool>(it, false);
+  }
+  if (d_size < s_inlineSize && d_data == d_inline)
+  {
+    d_inline[d_size] = value_type(key, val);
+  }
+  else
+  {
+    if (d_data == d_inline)
+    {
+      d_heap.assign(d_inline, d_inline + d_size);
+    }
+    d_heap.emplace_back(key, val);
+    d_data = d_heap.data();
+  }
+  d_size++;
+  if (d_size > s_hashThreshold)
+  {
+    if (d_index.empty())
+    {
+      for (size_t i = 0; i < d_size; i++)
+      {
+        d_index[d_data[i].first] = i;
+      }
+    }
+    else
+    {
+      d_index[key] = d_size - 1;
+    }
+  }
+  return std::pair<iterator, bool>(d_data + d_size - 1, true);
+}
+
+ExprValue*& Ctx::operator[](ExprValue* key)
+{
+  return emplace(key, nullptr).first->second;
+}
+
+void Ctx::keepAlive(ExprValue* e) { d_keep.emplace_back(e); }
+
+void Ctx::clear()
+{
+  d_size = 0;
+  d_keep.clear();
+  if (d_data != d_inline)
+  {
+    d_heap.clear();
+    d_index.clear();
+    d_data = d_inline;
+  }
+}
+
+}  // namespace ethos
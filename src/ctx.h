@@ -0,0 +1,116 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef CTX_H
+#define CTX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ethos {
+
+class Expr;
+class ExprValue;
+
+/**
+ * A substitution, mapping parameters to terms.
+ *
+ * Entries are stored in insertion order in a flat array, which is inline for
+ * small substitutions. Lookups are linear scans of this array, unless the
+ * substitution has more than s_hashThreshold entries, in which case a hash
+ * index of the array is maintained. The interface is a subset of that of
+ * std::map.
+ */
+class Ctx
+{
+ public:
+  using value_type = std::pair<ExprValue*, ExprValue*>;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+  Ctx();
+  Ctx(const Ctx& c);
+  Ctx(Ctx&& c);
+  ~Ctx();
+  Ctx& operator=(const Ctx& c);
+  Ctx& operator=(Ctx&& c);
+  /** Is this substitution empty? */
+  bool empty() const { return d_size == 0; }
+  /** The number of entries in this substitution */
+  size_t size() const { return d_size; }
+  iterator begin() { return d_data; }
+  iterator end() { return d_data + d_size; }
+  const_iterator begin() const { return d_data; }
+  const_iterator end() const { return d_data + d_size; }
+  const_iterator cbegin() const { return d_data; }
+  const_iterator cend() const { return d_data + d_size; }
+  /** Get the entry for key, or end() if none exists */
+  iterator find(const ExprValue* key)
+  {
+    return const_cast<iterator>(static_cast<const Ctx*>(this)->find(key));
+  }
+  const_iterator find(const ExprValue* key) const
+  {
+    if (d_size > s_hashThreshold)
+    {
+      return findHashed(key);
+    }
+    for (const_iterator it = d_data, itEnd = d_data + d_size; it != itEnd; ++it)
+    {
+      if (it->first == key)
+      {
+        return it;
+      }
+    }
+    return cend();
+  }
+  /**
+   * Add the entry key -> val if key has no entry. Returns the entry for key
+   * and whether it was added.
+   */
+  std::pair<iterator, bool> emplace(ExprValue* key, ExprValue* val);
+  /** Get the value for key, adding an entry to nullptr if none exists */
+  ExprValue*& operator[](ExprValue* key);
+  /**
+   * Hold a reference to e for as long as this substitution has entries. This
+   * is used for values that are constructed while matching, e.g. the heads
+   * of n-ary applications, which are otherwise not referenced.
+   */
+  void keepAlive(ExprValue* e);
+  /** Remove all entries */
+  void clear();
+
+ private:
+  /** The number of entries that are stored inline */
+  static const size_t s_inlineSize = 8;
+  /** The number of entries beyond which lookups are hashed */
+  static const size_t s_hashThreshold = 32;
+  /** Lookup in the hash index */
+  const_iterator findHashed(const ExprValue* key) const;
+  /** Copy the entries of c, where this substitution is empty */
+  void copyFrom(const Ctx& c);
+  /** Take the entries of c, where this substitution is empty */
+  void moveFrom(Ctx& c);
+  /** Pointer to the entries, either d_inline or the data of d_heap */
+  value_type* d_data;
+  /** The number of entries */
+  size_t d_size;
+  /** The inline entries */
+  value_type d_inline[s_inlineSize];
+  /** The entries, if there are more than s_inlineSize */
+  std::vector<value_type> d_heap;
+  /** Maps keys to their position, if there are more than s_hashThreshold */
+  std::unordered_map<const ExprValue*, size_t> d_index;
+  /** The terms this substitution holds a reference to, see keepAlive */
+  std::vector<Expr> d_keep;
+};
+
+}  // namespace ethos
+
+#endif /* CTX_H */
@@ -19,128 +19,104 @@ namespace ethos {
 ExprValue ExprValue::s_null;
 State* ExprValue::d_state = nullptr;
 
-ExprValue::ExprValue() : d_kind(Kind::NONE), d_flags(0), d_rc(0) {}
+bool ExprSpan::operator==(const std::vector<ExprValue*>& v) const
+{
+  if (d_size != v.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < d_size; i++)
+  {
+    if (d_data[i] != v[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+ExprValue::ExprValue()
+    : d_kind(Kind::NONE), d_rc(0), d_nchildren(0), d_flags(0), d_type(nullptr)
+{
+}
 
 ExprValue::ExprValue(Kind k, const std::vector<ExprValue*>& children)
-    : d_kind(k), d_children(children), d_flags(0), d_rc(0)
+    : d_kind(k),
+      d_rc(0),
+      d_nchildren(static_cast<uint32_t>(children.size())),
+      d_flags(0),
+      d_type(nullptr)
 {
-  for (ExprValue * c : children)
+  ExprValue** data = getChildrenData();
+  for (size_t i = 0, nchildren = children.size(); i < nchildren; i++)
   {
-    c->inc();
+    data[i] = children[i];
+    data[i]->inc();
   }
+  computeFlags();
+}
+
+ExprValue::~ExprValue()
+{
+  // Note that children are not garbage collected when their parent is
+  // deleted, hence we do not decrement their reference counts here.
 }
-ExprValue::~ExprValue() 
+
+const Literal* ExprValue::asLiteral() const
 {
-  for (ExprValue * c : d_children)
+  // literals and symbols are the only expressions that are of class Literal
+  if (isLiteral(d_kind) || isSymbol(d_kind))
   {
-    c->dec();
+    return static_cast<const Literal*>(this);
   }
+  return nullptr;
 }
 
 bool ExprValue::isNull() const { return d_kind==Kind::NONE; }
   
 Kind ExprValue::getKind() const { return d_kind; }
 
-const std::vector<ExprValue*>& ExprValue::getChildren() const { return d_children; }
+ExprSpan ExprValue::getChildren() const
+{
+  return ExprSpan(getChildrenData(), d_nchildren);
+}
 
 size_t ExprValue::getNumChildren() const
 {
-  return d_children.size();
+  return d_nchildren;
 }
-ExprValue* ExprValue::operator[](size_t i) const { return d_children[i]; }
+ExprValue* ExprValue::operator[](size_t i) const { return getChildrenData()[i]; }
 
 void ExprValue::computeFlags()
 {
-  if (getFlag(Flag::IS_FLAGS_COMPUTED))
+  if (d_nchildren == 0)
   {
+    setFlag(Flag::IS_NON_GROUND, d_kind == Kind::PARAM);
     return;
   }
-  std::unordered_set<ExprValue*> visited;
-  std::vector<ExprValue*> visit;
-  visit.emplace_back(this);
-  ExprValue * cur;
-  do
+  ExprValue** children = getChildrenData();
+  if (d_kind == Kind::APPLY)
   {
-    cur = visit.back();
-    cur->setFlag(Flag::IS_FLAGS_COMPUTED, true);
-    Kind ck = cur->getKind();
-    std::vector<ExprValue*>& children = cur->d_children;
-    if (children.empty())
-    {
-      bool isNonGround = (ck==Kind::PARAM);
-      cur->setFlag(Flag::IS_EVAL, false);
-      cur->setFlag(Flag::IS_NON_GROUND, isNonGround);
-      visit.pop_back();
-    }
-    else if (visited.find(cur)==visited.end())
+    Kind cck = children[0]->getKind();
+    if (cck == Kind::PROGRAM_CONST || cck == Kind::ORACLE)
     {
-      visited.insert(cur);
-      for (ExprValue* c : children)
-      {
-        if (!c->getFlag(Flag::IS_FLAGS_COMPUTED))
-        {
-          visit.push_back(c);
-        }
-      }
-    }
-    else
-    {
-      visit.pop_back();
-      if (ck==Kind::APPLY)
-      {
-        Kind cck = children[0]->getKind();
-        if (cck==Kind::PROGRAM_CONST || cck==Kind::ORACLE)
-        {
-          cur->setFlag(Flag::IS_PROG_EVAL, true);
-          cur->setFlag(Flag::IS_EVAL, true);
-        }
-      }
-      else if (isLiteralOp(ck))
-      {
-        // requires type and literal operator kinds evaluate
-        cur->setFlag(Flag::IS_EVAL, true);
-      }
-      for (ExprValue* c : children)
-      {
-        if (c->getFlag(Flag::IS_NON_GROUND))
-        {
-          cur->setFlag(Flag::IS_NON_GROUND, true);
-        }
-        if (c->getFlag(Flag::IS_EVAL))
-        {
-          cur->setFlag(Flag::IS_EVAL, true);
-        }
-        if (c->getFlag(Flag::IS_PROG_EVAL))
-        {
-          cur->setFlag(Flag::IS_PROG_EVAL, true);
-        }
-      }
+      setFlag(Flag::IS_PROG_EVAL, true);
+      setFlag(Flag::IS_EVAL, true);
     }
   }
-  while (!visit.empty());
-}
-bool ExprValue::isEvaluatable()
-{
-  computeFlags();
-  return getFlag(ExprValue::Flag::IS_EVAL);
-}
-
-bool ExprValue::isGround()
-{
-  computeFlags();
-  return !getFlag(ExprValue::Flag::IS_NON_GROUND);
-}
-
-bool ExprValue::isProgEvaluatable()
-{
-  computeFlags();
-  return getFlag(ExprValue::Flag::IS_PROG_EVAL);
-}
-
-bool ExprValue::isCompiled()
-{
-  // this is set manually
-  return getFlag(ExprValue::Flag::IS_COMPILED);
+  else if (isLiteralOp(d_kind))
+  {
+    // requires type and literal operator kinds evaluate
+    setFlag(Flag::IS_EVAL, true);
+  }
+  // the remaining flags are inherited from the children
+  char cflags = static_cast<char>(static_cast<uint8_t>(Flag::IS_EVAL)
+                                  | static_cast<uint8_t>(Flag::IS_PROG_EVAL)
+                                  | static_cast<uint8_t>(Flag::IS_NON_GROUND));
+  for (uint32_t i = 0; i < d_nchildren; i++)
+  {
+    d_flags |= (children[i]->d_flags & cflags);
+  }
 }
 
 void ExprValue::dec()
@@ -464,7 +440,7 @@ std::vector<Expr> Expr::getVariables(const std::vector<Expr>& es)
 
 size_t Expr::getNumChildren() const { return d_value->getNumChildren(); }
 
-Expr Expr::operator[](size_t i) const { return Expr(d_value->d_children[i]); }
+Expr Expr::operator[](size_t i) const { return Expr((*d_value)[i]); }
 
 Expr& Expr::operator=(const Expr& e)
 {
@@ -556,7 +532,7 @@ std::ostream& operator<<(std::ostream& out, const Ctx& c)
 {
   out << "[";
   bool firstTime = true;
-  for (const std::pair<ExprValue* const, ExprValue*>& cc : c)
+  for (const Ctx::value_type& cc : c)
   {
     if (firstTime)
     {
@@ -13,6 +13,7 @@
 #include <unordered_set>
 #include <vector>
 #include <memory>
+#include "ctx.h"
 #include "kind.h"
 
 namespace ethos {
@@ -23,27 +24,68 @@ class TypeChecker;
 class Expr;
 class Literal;
 
+/**
+ * A read-only view of a contiguous range of expressions, e.g. the children
+ * of an expression.
+ */
+class ExprSpan
+{
+ public:
+  ExprSpan() : d_data(nullptr), d_size(0) {}
+  ExprSpan(ExprValue* const* data, size_t size) : d_data(data), d_size(size) {}
+  ExprSpan(const std::vector<ExprValue*>& v) : d_data(v.data()), d_size(v.size())
+  {
+  }
+  ExprValue* const* begin() const { return d_data; }
+  ExprValue* const* end() const { return d_data + d_size; }
+  size_t size() const { return d_size; }
+  bool empty() const { return d_size == 0; }
+  ExprValue* operator[](size_t i) const { return d_data[i]; }
+  ExprValue* back() const { return d_data[d_size - 1]; }
+  /** Returns true if this span has the same elements as v */
+  bool operator==(const std::vector<ExprValue*>& v) const;
+
+ private:
+  /** The data */
+  ExprValue* const* d_data;
+  /** The number of elements */
+  size_t d_size;
+};
+
 /** 
  * Expression class
+ *
+ * The children of an expression are stored inline, immediately after the
+ * expression itself. Hence, expressions with children must be constructed in
+ * memory of size getAllocSize(n), where n is the number of children, as is
+ * done in State::mkExprInternal.
  */
 class ExprValue
 {
   friend class TypeChecker;
   friend class Expr;
   friend class State;
+  friend class ProgramMemo;
+  friend class InstCache;
+  friend class ListCache;
 
  public:
   ExprValue();
   ExprValue(Kind k, const std::vector<ExprValue*>& children);
   ~ExprValue();
-  /** as literal */
-  virtual const Literal* asLiteral() const { return nullptr; }
+  /** The number of bytes required to store an expression with n children */
+  static size_t getAllocSize(size_t n)
+  {
+    return sizeof(ExprValue) + n * sizeof(ExprValue*);
+  }
+  /** as literal, returns nullptr if this is not a literal or symbol */
+  const Literal* asLiteral() const;
   /** is null? */
   bool isNull() const;
   /** get the kind of this expression */
   Kind getKind() const;
   /** Get children */
-  const std::vector<ExprValue*>& getChildren() const;
+  ExprSpan getChildren() const;
   /** Get num children */
   size_t getNumChildren() const;  
   /**
@@ -53,32 +95,55 @@ class ExprValue
    */
   ExprValue* operator[](size_t i) const;
   /** Has variable */
-  bool isEvaluatable();
+  bool isEvaluatable() const { return getFlag(Flag::IS_EVAL); }
   /** Has variable */
-  bool isGround();
+  bool isGround() const { return !getFlag(Flag::IS_NON_GROUND); }
   /** Has program variable */
-  bool isProgEvaluatable();
+  bool isProgEvaluatable() const { return getFlag(Flag::IS_PROG_EVAL); }
   /** Is part of compiled code */
-  bool isCompiled();
+  bool isCompiled() const { return getFlag(Flag::IS_COMPILED); }
  protected:
   /** The kind */
   Kind d_kind;
-  /** The children of this expression */
-  std::vector<ExprValue*> d_children;
-  /** flags */
+  /** */
+  uint32_t d_rc;
+  /** The number of children, which are stored after this expression */
+  uint32_t d_nchildren;
+  /**
+   * Flags. The flags IS_EVAL, IS_PROG_EVAL and IS_NON_GROUND are computed
+   * when the expression is constructed, based on its kind and the flags of
+   * its children.
+   */
   enum class Flag
   {
     NONE = 0,
-    IS_FLAGS_COMPUTED = (1 << 0),
-    IS_EVAL = (1 << 1),
-    IS_PROG_EVAL = (1 << 2),
-    IS_NON_GROUND = (1 << 3),
-    IS_COMPILED = (1 << 4)
+    IS_EVAL = (1 << 0),
+    IS_PROG_EVAL = (1 << 1),
+    IS_NON_GROUND = (1 << 2),
+    IS_COMPILED = (1 << 3),
+    // whether this has an entry in State::d_appData
+    HAS_APP_INFO = (1 << 4),
+    // whether this has an entry in State::d_hashMap
+    HAS_HASH = (1 << 5),
+    // whether this has an entry in State::d_listCache
+    HAS_LIST_CACHE = (1 << 6)
   };
   char d_flags;
-  /** */
-  uint32_t d_rc;
-  /** Compute flags */
+  /**
+   * The type of this expression if it has been computed, or nullptr
+   * otherwise. This expression holds a reference to its type.
+   */
+  ExprValue* d_type;
+  /** Get a pointer to the children of this expression */
+  ExprValue** getChildrenData()
+  {
+    return reinterpret_cast<ExprValue**>(this + 1);
+  }
+  ExprValue* const* getChildrenData() const
+  {
+    return reinterpret_cast<ExprValue* const*>(this + 1);
+  }
+  /** Compute the flags of this expression from its kind and children */
   void computeFlags();
   /** Get flag */
   bool getFlag(Flag f) const
@@ -184,7 +249,6 @@ class Expr
 std::ostream& operator<<(std::ostream& out, const Expr& e);
 std::ostream& operator<<(std::ostream& out, const std::vector<ExprValue*>& es);
 
-using Ctx = std::map<ExprValue*, ExprValue*>;
 std::ostream& operator<<(std::ostream& out, const Ctx& c);
 
 }  // namespace ethos
@@ -16,6 +16,7 @@
 #include "kind.h"
 #include "attr.h"
 #include "expr.h"
+#include "program_index.h"
 
 namespace ethos {
 
@@ -39,6 +40,8 @@ public:
    * bound, including itself. This vector is either empty or has size >=2.
    */
   std::vector<Expr> d_overloads;
+  /** The index of the cases, if this is a program with a definition */
+  std::unique_ptr<ProgramIndex> d_progIndex;
 };
 
 }  // namespace ethos
@@ -14,6 +14,7 @@
 
 #include "base/check.h"
 #include "base/output.h"
+#include "keywords.h"
 #include "type_checker.h"
 
 namespace ethos {
@@ -76,31 +77,6 @@ enum class ParseCtx
 ExprParser::ExprParser(Lexer& lex, State& state, bool isSignature)
     : d_lex(lex), d_state(state), d_isSignature(isSignature)
 {
-  d_strToAttr[":var"] = Attr::VAR;
-  d_strToAttr[":implicit"] = Attr::IMPLICIT;
-  d_strToAttr[":type"] = Attr::TYPE;
-  d_strToAttr[":list"] = Attr::LIST;
-  d_strToAttr[":requires"] = Attr::REQUIRES;
-  d_strToAttr[":left-assoc"] = Attr::LEFT_ASSOC;
-  d_strToAttr[":right-assoc"] = Attr::RIGHT_ASSOC;
-  d_strToAttr[":left-assoc-nil"] = Attr::LEFT_ASSOC_NIL;
-  d_strToAttr[":right-assoc-nil"] = Attr::RIGHT_ASSOC_NIL;
-  d_strToAttr[":chainable"] = Attr::CHAINABLE;
-  d_strToAttr[":pairwise"] = Attr::PAIRWISE;
-  d_strToAttr[":binder"] = Attr::BINDER;
-  d_strToAttr[":let-binder"] = Attr::LET_BINDER;
-  d_strToAttr[":opaque"] = Attr::OPAQUE;
-  d_strToAttr[":syntax"] = Attr::SYNTAX;
-  d_strToAttr[":restrict"] = Attr::RESTRICT;
-  d_strToAttr[":sorry"] = Attr::SORRY;
-  
-  d_strToLiteralKind["<boolean>"] = Kind::BOOLEAN;
-  d_strToLiteralKind["<numeral>"] = Kind::NUMERAL;
-  d_strToLiteralKind["<decimal>"] = Kind::DECIMAL;
-  d_strToLiteralKind["<rational>"] = Kind::RATIONAL;
-  d_strToLiteralKind["<hexadecimal>"] = Kind::HEXADECIMAL;
-  d_strToLiteralKind["<binary>"] = Kind::BINARY;
-  d_strToLiteralKind["<string>"] = Kind::STRING;
 }
 
 class StackFrame
@@ -184,9 +160,8 @@ Expr ExprParser::parseExpr()
           case Token::QUOTED_SYMBOL:
           {
             // function identifier
-            std::string name = tokenStrToSymbol(tok);
             std::vector<Expr> args;
-            Expr v = getVar(name);
+            Expr v = getVar(tokenStrToSymbolView(tok));
             args.push_back(v);
             size_t nscopes = 0;
             // if a binder, read a variable list and push a scope
@@ -278,8 +253,7 @@ Expr ExprParser::parseExpr()
       case Token::SYMBOL:
       case Token::QUOTED_SYMBOL:
       {
-        std::string name = tokenStrToSymbol(tok);
-        ret = getVar(name);
+        ret = getVar(tokenStrToSymbolView(tok));
       }
       break;
       case Token::INTEGER_LITERAL:
@@ -1062,15 +1036,19 @@ uint32_t ExprParser::tokenStrToUnsigned()
 
 std::string ExprParser::tokenStrToSymbol(Token tok)
 {
-  std::string id;
+  return std::string(tokenStrToSymbolView(tok));
+}
+
+std::string_view ExprParser::tokenStrToSymbolView(Token tok)
+{
+  std::string_view id;
   switch (tok)
   {
-    case Token::SYMBOL: id = d_lex.tokenStr(); break;
+    case Token::SYMBOL: id = d_lex.tokenView(); break;
     case Token::QUOTED_SYMBOL:
-      id = d_lex.tokenStr();
+      id = d_lex.tokenView();
       // strip off the quotes
-      id = id.erase(0, 1);
-      id = id.erase(id.size() - 1, 1);
+      id = id.substr(1, id.size() - 2);
       break;
     case Token::UNTERMINATED_QUOTED_SYMBOL:
       d_lex.parseError("Expected SMT-LIBv2 symbol", true);
@@ -1095,15 +1073,14 @@ std::string ExprParser::parseStr(bool unescape)
 
 void ExprParser::parseAttributeList(Kind k, Expr& e, AttrMap& attrs, bool& pushedScope)
 {
-  std::map<std::string, Attr>::iterator its;
   // while the next token is KEYWORD, exit if RPAREN
   while (d_lex.eatTokenChoice(Token::KEYWORD, Token::RPAREN))
   {
-    std::string key = d_lex.tokenStr();
-    its = d_strToAttr.find(key);
+    const Keyword* kw = Keyword::find(d_lex.tokenView());
     Expr val;
-    if (its==d_strToAttr.end())
+    if (kw == nullptr || kw->d_category != Keyword::Category::ATTRIBUTE)
     {
+      std::string key = d_lex.tokenStr();
       // parse and skip value if it exists
       Token tok = d_lex.peekToken();
       if (tok!=Token::KEYWORD && tok!=Token::RPAREN)
@@ -1115,7 +1092,7 @@ void ExprParser::parseAttributeList(Kind k, Expr& e, AttrMap& attrs, bool& pushe
       attrs[Attr::NONE].push_back(val);
       continue;
     }
-    Attr a = its->second;
+    Attr a = kw->d_attr;
     bool handled = false;
     // split on the context of the attribute, as given by a kind
     switch (k)
@@ -1245,9 +1222,9 @@ void ExprParser::parseAttributeList(Kind k, Expr& e, AttrMap& attrs, bool& pushe
     }
     if (!handled)
     {
-      d_lex.parseError("Unhandled attribute " + key);
+      d_lex.parseError("Unhandled attribute " + std::string(kw->d_name));
     }
-    attrs[its->second].push_back(val);
+    attrs[a].push_back(val);
   }
   d_lex.reinsertToken(Token::RPAREN);
 }
@@ -1266,14 +1243,14 @@ void ExprParser::parseAttributeList(Kind k, Expr& e, AttrMap& attrs)
 Kind ExprParser::parseLiteralKind()
 {
   std::string name = parseSymbol();
-  std::map<std::string, Kind>::iterator it = d_strToLiteralKind.find(name);
-  if (it==d_strToLiteralKind.end())
+  const Keyword* kw = Keyword::find(name);
+  if (kw == nullptr || kw->d_category != Keyword::Category::LITERAL_KIND)
   {
     std::stringstream ss;
     ss << "Unknown literal kind " << name;
     d_lex.parseError(ss.str());
   }
-  return it->second;
+  return kw->d_kind;
 }
 
 void ExprParser::unescapeString(std::string& s)
@@ -1303,7 +1280,7 @@ void ExprParser::unescapeString(std::string& s)
   s.erase(dst);
 }
 
-Expr ExprParser::getVar(const std::string& name)
+Expr ExprParser::getVar(std::string_view name)
 {
   Expr ret = d_state.getVar(name);
   if (ret.isNull())
@@ -1315,7 +1292,7 @@ Expr ExprParser::getVar(const std::string& name)
   return ret;
 }
 
-Expr ExprParser::getProofRule(const std::string& name)
+Expr ExprParser::getProofRule(std::string_view name)
 {
   Expr v = d_state.getProofRule(name);
   if (v.isNull())
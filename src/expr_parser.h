@@ -134,9 +134,9 @@ class ExprParser
   /** ensure type */
   Expr typeCheck(Expr& e, const Expr& expected);
   /** get variable, else error */
-  Expr getVar(const std::string& name);
+  Expr getVar(std::string_view name);
   /** get variable, else error */
-  Expr getProofRule(const std::string& name);
+  Expr getProofRule(std::string_view name);
   /** Bind, or throw error otherwise */
   void bind(const std::string& name, Expr& e);
   /** Ensure bound */
@@ -173,6 +173,11 @@ class ExprParser
    * tok is QUOTED_SYMBOL.
    */
   std::string tokenStrToSymbol(Token tok);
+  /**
+   * Same as above, but returns a view of the lexer's token string, which is
+   * only valid until the next token is read.
+   */
+  std::string_view tokenStrToSymbolView(Token tok);
   /**
    * Unescape string, which updates s based on processing escape sequences
    * as defined in SMT2.
@@ -186,10 +191,6 @@ class ExprParser
   State& d_state;
   /** Are we parsing a signature file? */
   bool d_isSignature;
-  /** Strings to attributes */
-  std::map<std::string, Attr> d_strToAttr;
-  /** Mapping symbols to literal kinds */
-  std::map<std::string, Kind> d_strToLiteralKind;
 };
 
 }  // namespace cvc5
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "expr_table.h"
+
+#include <cstdint>
+
+#include "base/check.h"
+#include "stats.h"
+
+namespace ethos {
+
+/** The initial number of slots, must be a power of two. */
+static const size_t s_initCapacity = 1024;
+
+ExprTable::ExprTable(Stats& stats)
+    : d_slots(s_initCapacity),
+      d_size(0),
+      d_mask(s_initCapacity - 1),
+      d_stats(stats)
+{
+}
+
+ExprTable::~ExprTable() {}
+
+size_t ExprTable::computeHash(Kind k, ExprSpan children)
+{
+  uint64_t h = static_cast<uint64_t>(k) * 0x9e3779b97f4a7c15ULL;
+  for (const ExprValue* c : children)
+  {
+    // low bits of pointers are always zero due to alignment
+    h ^= reinterpret_cast<uintptr_t>(c) >> 4;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 32;
+  }
+  // finalize so that all bits impact the index of the slot
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+ExprValue* ExprTable::find(Kind k,
+                           const std::vector<ExprValue*>& children,
+                           size_t h)
+{
+  d_stats.d_hashConsLookups++;
+  size_t i = h & d_mask;
+  size_t nprobes = 1;
+  ExprValue* ret = nullptr;
+  while (d_slots[i].d_value != nullptr)
+  {
+    const Slot& s = d_slots[i];
+    if (s.d_hash == h && s.d_value->getKind() == k
+        && s.d_value->getChildren() == children)
+    {
+      ret = s.d_value;
+      break;
+    }
+    i = (i + 1) & d_mask;
+    nprobes++;
+  }
+  d_stats.d_hashConsProbes += nprobes;
+  if (nprobes > d_stats.d_hashConsMaxProbe)
+  {
+    d_stats.d_hashConsMaxProbe = nprobes;
+  }
+  return ret;
+}
+
+void ExprTable::insert(ExprValue* e, size_t h)
+{
+  Assert(e != nullptr);
+  // keep the load factor below 0.7
+  if (10 * (d_size + 1) > 7 * d_slots.size())
+  {
+    grow();
+  }
+  size_t i = h & d_mask;
+  while (d_slots[i].d_value != nullptr)
+  {
+    i = (i + 1) & d_mask;
+  }
+  d_slots[i].d_hash = h;
+  d_slots[i].d_value = e;
+  d_size++;
+}
+
+void ExprTable::remove(ExprValue* e)
+{
+  size_t h = computeHash(e->getKind(), e->getChildren());
+  size_t i = h & d_mask;
+  while (d_slots[i].d_value != e)
+  {
+    if (d_slots[i].d_value == nullptr)
+    {
+      // not in the table
+      return;
+    }
+    i = (i + 1) & d_mask;
+  }
+  // Backward shift deletion: move subsequent entries of the cluster into the
+  // hole if their ideal slot does not lie strictly after the hole.
+  size_t j = i;
+  for (;;)
+  {
+    j = (j + 1) & d_mask;
+    if (d_slots[j].d_value == nullptr)
+    {
+      break;
+    }
+    size_t ideal = d_slots[j].d_hash & d_mask;
+    if (((j - ideal) & d_mask) >= ((j - i) & d_mask))
+    {
+      d_slots[i] = d_slots[j];
+      i = j;
+    }
+  }
+  d_slots[i] = Slot();
+  d_size--;
+}
+
+size_t ExprTable::size() const { return d_size; }
+
+void ExprTable::grow()
+{
+  std::vector<Slot> old;
+  old.swap(d_slots);
+  d_slots.resize(old.size() * 2);
+  d_mask = d_slots.size() - 1;
+  for (const Slot& s : old)
+  {
+    if (s.d_value != nullptr)
+    {
+      size_t i = s.d_hash & d_mask;
+      while (d_slots[i].d_value != nullptr)
+      {
+        i = (i + 1) & d_mask;
+      }
+      d_slots[i] = s;
+    }
+  }
+}
+
+}  // namespace ethos
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef EXPR_TABLE_H
+#define EXPR_TABLE_H
+
+#include <vector>
+
+#include "expr.h"
+#include "kind.h"
+
+namespace ethos {
+
+class Stats;
+
+/**
+ * The hash-consing table for expressions, which maps (Kind, children) to the
+ * unique expression with that kind and children.
+ *
+ * This is an open addressing hash table with linear probing. Each slot stores
+ * the structural hash of its expression, so that probing and resizing never
+ * need to rehash children. Removal uses backward shift deletion, so the table
+ * never contains tombstones.
+ */
+class ExprTable
+{
+ public:
+  ExprTable(Stats& stats);
+  ~ExprTable();
+  /** Compute the structural hash of an expression (<k> children). */
+  static size_t computeHash(Kind k, ExprSpan children);
+  /**
+   * Find the expression (<k> children) whose structural hash is h, or nullptr
+   * if it does not exist.
+   */
+  ExprValue* find(Kind k, const std::vector<ExprValue*>& children, size_t h);
+  /** Insert e, whose structural hash is h, assumes e is not in this table. */
+  void insert(ExprValue* e, size_t h);
+  /** Remove e from this table, if it exists. */
+  void remove(ExprValue* e);
+  /** Get the number of expressions stored in this table. */
+  size_t size() const;
+
+ private:
+  /** A slot of the table, which is empty if d_value is nullptr. */
+  struct Slot
+  {
+    Slot() : d_hash(0), d_value(nullptr) {}
+    size_t d_hash;
+    ExprValue* d_value;
+  };
+  /** Double the capacity of this table, reinserting all expressions. */
+  void grow();
+  /** The slots, whose size is always a power of two. */
+  std::vector<Slot> d_slots;
+  /** The number of non-empty slots */
+  size_t d_size;
+  /** The size of d_slots minus one */
+  size_t d_mask;
+  /** Reference to stats */
+  Stats& d_stats;
+};
+
+}  // namespace ethos
+
+#endif /* EXPR_TABLE_H */
@@ -8,8 +8,21 @@
  ******************************************************************************/
 #include "input.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
 
 #include "base/check.h"
 
@@ -32,6 +45,63 @@ class FileInput : public Input
   /** File stream */
   std::ifstream d_fs;
 };
+/** Memory-mapped file input class */
+class MappedFileInput : public Input
+{
+ public:
+  /** Map the given file, or return nullptr if it cannot be mapped */
+  static MappedFileInput* map(const std::string& filename)
+  {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      close(fd);
+      return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = nullptr;
+    if (size > 0)
+    {
+      data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED)
+      {
+        close(fd);
+        return nullptr;
+      }
+      // the file is lexed from beginning to end
+      madvise(data, size, MADV_SEQUENTIAL);
+    }
+    // the mapping remains valid after the file is closed
+    close(fd);
+    return new MappedFileInput(static_cast<const char*>(data), size);
+  }
+  ~MappedFileInput()
+  {
+    if (d_size > 0)
+    {
+      munmap(const_cast<char*>(d_data), d_size);
+    }
+  }
+  /** The contents are read from getData only */
+  std::istream* getStream() override { return nullptr; }
+  const char* getData() const override { return d_size > 0 ? d_data : ""; }
+  size_t getSize() const override { return d_size; }
+
+ private:
+  MappedFileInput(const char* data, size_t size)
+      : Input(), d_data(data), d_size(size)
+  {
+  }
+  /** The mapped contents of the file */
+  const char* d_data;
+  /** The size of the file */
+  size_t d_size;
+};
 /** Stream reference input class */
 class StreamInput : public Input
 {
@@ -44,6 +114,184 @@ class StreamInput : public Input
   /** Reference to stream */
   std::istream& d_input;
 };
+/**
+ * The state shared by a piped stream buffer and its reader thread. The reader
+ * thread fills the two blocks alternately, and the stream buffer consumes
+ * them in the same order. A block is full if it was filled by the reader and
+ * not yet released by the stream buffer.
+ */
+class PipeReader
+{
+ public:
+  PipeReader(int fd) : d_fd(fd), d_eof(false), d_stop(false)
+  {
+    for (size_t i = 0; i < 2; i++)
+    {
+      d_blocks[i].resize(s_blockSize);
+      d_sizes[i] = 0;
+      d_full[i] = false;
+    }
+  }
+  /** Read the file descriptor until its end, or until stopped */
+  void run()
+  {
+    for (size_t i = 0;; i ^= 1)
+    {
+      {
+        std::unique_lock<std::mutex> lock(d_mutex);
+        d_cv.wait(lock, [this, i] { return !d_full[i] || d_stop; });
+        if (d_stop)
+        {
+          return;
+        }
+      }
+      // Fill the block, which the consumer does not access until it is
+      // full. We stop early if no more input is available for now, so that
+      // the input that was read is not delayed.
+      size_t size = 0;
+      bool eof = false;
+      while (size < s_blockSize)
+      {
+        ssize_t n = ::read(d_fd, d_blocks[i].data() + size, s_blockSize - size);
+        if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (n <= 0)
+        {
+          eof = true;
+          break;
+        }
+        size += static_cast<size_t>(n);
+        struct pollfd pfd;
+        pfd.fd = d_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 0) == 0)
+        {
+          break;
+        }
+      }
+      std::unique_lock<std::mutex> lock(d_mutex);
+      d_sizes[i] = size;
+      d_full[i] = true;
+      d_eof = eof;
+      d_cv.notify_all();
+      if (eof)
+      {
+        return;
+      }
+    }
+  }
+  /** The size of blocks */
+  static const size_t s_blockSize = 1 << 20;
+  /** The file descriptor */
+  int d_fd;
+  /** The blocks, their sizes and whether they are full */
+  std::vector<char> d_blocks[2];
+  size_t d_sizes[2];
+  bool d_full[2];
+  /** Whether the reader has reached the end of the input */
+  bool d_eof;
+  /** Whether the reader should stop */
+  bool d_stop;
+  /** For synchronizing the above */
+  std::mutex d_mutex;
+  std::condition_variable d_cv;
+};
+/** Stream buffer for the blocks of a pipe reader */
+class PipedBuf : public std::streambuf
+{
+ public:
+  PipedBuf(int fd) : d_reader(new PipeReader(fd)), d_current(-1)
+  {
+    std::shared_ptr<PipeReader> r = d_reader;
+    d_thread = std::thread([r]() { r->run(); });
+  }
+  ~PipedBuf()
+  {
+    bool eof;
+    {
+      std::unique_lock<std::mutex> lock(d_reader->d_mutex);
+      d_reader->d_stop = true;
+      eof = d_reader->d_eof;
+      d_reader->d_cv.notify_all();
+    }
+    // if the input was not read until its end, e.g. due to an exit command,
+    // the reader may be blocked on reading, in which case we do not wait
+    // for it. It shares ownership of its state.
+    if (eof)
+    {
+      d_thread.join();
+    }
+    else
+    {
+      d_thread.detach();
+    }
+  }
+
+ protected:
+  int_type underflow() override
+  {
+    std::unique_lock<std::mutex> lock(d_reader->d_mutex);
+    size_t next = 0;
+    if (d_current >= 0)
+    {
+      // release the current block to the reader
+      d_reader->d_full[d_current] = false;
+      d_reader->d_cv.notify_all();
+      next = static_cast<size_t>(d_current) ^ 1;
+    }
+    d_reader->d_cv.wait(
+        lock, [this, next] { return d_reader->d_full[next] || d_reader->d_eof; });
+    d_current = static_cast<int>(next);
+    if (!d_reader->d_full[next] || d_reader->d_sizes[next] == 0)
+    {
+      setg(nullptr, nullptr, nullptr);
+      return traits_type::eof();
+    }
+    char* data = d_reader->d_blocks[next].data();
+    setg(data, data, data + d_reader->d_sizes[next]);
+    return traits_type::to_int_type(*data);
+  }
+  /**
+   * Get at most n characters, which are taken from the current block only.
+   * Hence, this does not wait for more input than is necessary to return
+   * one character.
+   */
+  std::streamsize xsgetn(char* s, std::streamsize n) override
+  {
+    if (gptr() == egptr()
+        && traits_type::eq_int_type(underflow(), traits_type::eof()))
+    {
+      return 0;
+    }
+    std::streamsize avail = std::min(n, static_cast<std::streamsize>(egptr() - gptr()));
+    std::copy(gptr(), gptr() + avail, s);
+    gbump(static_cast<int>(avail));
+    return avail;
+  }
+
+ private:
+  /** The state shared with the reader thread */
+  std::shared_ptr<PipeReader> d_reader;
+  /** The reader thread */
+  std::thread d_thread;
+  /** The index of the block we are reading from, or -1 if none */
+  int d_current;
+};
+/** Piped input class */
+class PipedInput : public Input
+{
+ public:
+  PipedInput(int fd) : Input(), d_buf(fd), d_stream(&d_buf) {}
+  std::istream* getStream() override { return &d_stream; }
+
+ private:
+  /** The stream buffer */
+  PipedBuf d_buf;
+  /** The stream */
+  std::istream d_stream;
+};
 /** String input class */
 class StringInput : public Input
 {
@@ -62,14 +310,28 @@ Input::Input() {}
 
 bool Input::isInteractive() const { return false; }
 
+const char* Input::getData() const { return nullptr; }
+
+size_t Input::getSize() const { return 0; }
+
 std::unique_ptr<Input> Input::mkFileInput(const std::string& filename)
 {
-  return std::unique_ptr<Input>(new FileInput(filename));
+  Input* in = MappedFileInput::map(filename);
+  if (in == nullptr)
+  {
+    // otherwise we read it as a stream, e.g. if it is not a regular file
+    in = new FileInput(filename);
+  }
+  return std::unique_ptr<Input>(in);
 }
 std::unique_ptr<Input> Input::mkStreamInput(std::istream& input)
 {
   return std::unique_ptr<Input>(new StreamInput(input));
 }
+std::unique_ptr<Input> Input::mkPipedInput(int fd)
+{
+  return std::unique_ptr<Input>(new PipedInput(fd));
+}
 std::unique_ptr<Input> Input::mkStringInput(const std::string& input)
 {
   return std::unique_ptr<Input>(new StringInput(input));
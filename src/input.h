@@ -18,14 +18,16 @@ namespace ethos {
 /**
  * Wrapper to setup the necessary information for constructing a Lexer.
  *
- * Currently this is std::istream& obtainable via getStream.
+ * This is either the contents of the input in memory, obtainable via getData,
+ * or otherwise an std::istream& obtainable via getStream.
  */
 class Input
 {
  public:
   Input();
   virtual ~Input() {}
-  /** Set the input for the given file.
+  /** Set the input for the given file. The file is memory-mapped if
+   * possible.
    *
    * @param filename the input filename
    */
@@ -35,6 +37,14 @@ class Input
    * @param input the input
    */
   static std::unique_ptr<Input> mkStreamInput(std::istream& input);
+  /** Set the input for the given file descriptor, e.g. a pipe.
+   *
+   * The input is read in large blocks by a separate thread, which reads the
+   * next block while the current one is being parsed.
+   *
+   * @param fd the file descriptor
+   */
+  static std::unique_ptr<Input> mkPipedInput(int fd);
   /** Set the input for the given string.
    *
    * @param input the input
@@ -42,6 +52,15 @@ class Input
   static std::unique_ptr<Input> mkStringInput(const std::string& input);
   /** Get the stream to pass to the lexer. */
   virtual std::istream* getStream() = 0;
+  /**
+   * Get the contents of the input, if they are in memory, e.g. for files that
+   * are memory-mapped. Returns nullptr otherwise, in which case the input
+   * is read from getStream. The contents are valid for the lifetime of this
+   * input.
+   */
+  virtual const char* getData() const;
+  /** Get the size of the contents returned by getData */
+  virtual size_t getSize() const;
   /**
    * Is the stream of this input an interactive input? If so, we will read
    * it character-by-character.
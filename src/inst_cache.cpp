@@ -0,0 +1,146 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "inst_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace ethos {
+
+InstCache::InstCache() : d_clock(0) {}
+
+InstCache::~InstCache() {}
+
+size_t InstCache::mkKey(ExprValue* type, const Ctx& ctx)
+{
+  d_scratch.clear();
+  d_scratch.push_back(type);
+  for (const Ctx::value_type& c : ctx)
+  {
+    d_scratch.push_back(c.first);
+    d_scratch.push_back(c.second);
+  }
+  size_t h = d_scratch.size();
+  for (const ExprValue* e : d_scratch)
+  {
+    h = (h ^ std::hash<const ExprValue*>()(e)) * 0x9e3779b97f4a7c15ULL;
+    h ^= (h >> 32);
+  }
+  return h;
+}
+
+bool InstCache::hasScratchKey(const Entry& e) const
+{
+  if (e.d_key.size() != d_scratch.size())
+  {
+    return false;
+  }
+  for (size_t i = 0, nkey = d_scratch.size(); i < nkey; i++)
+  {
+    if (e.d_key[i].getValue() != d_scratch[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool InstCache::find(ExprValue* type, const Ctx& ctx, Expr& result)
+{
+  size_t h = mkKey(type, ctx);
+  std::pair<std::unordered_multimap<size_t, Entry>::iterator,
+            std::unordered_multimap<size_t, Entry>::iterator>
+      range = d_entries.equal_range(h);
+  for (std::unordered_multimap<size_t, Entry>::iterator it = range.first;
+       it != range.second;
+       ++it)
+  {
+    if (hasScratchKey(it->second))
+    {
+      it->second.d_lastUse = ++d_clock;
+      result = it->second.d_result;
+      return true;
+    }
+  }
+  return false;
+}
+
+void InstCache::insert(ExprValue* type, const Ctx& ctx, const Expr& result)
+{
+  size_t h = mkKey(type, ctx);
+  Entry& e = d_entries.emplace(h, Entry())->second;
+  e.d_key.reserve(d_scratch.size());
+  for (ExprValue* k : d_scratch)
+  {
+    e.d_key.emplace_back(k);
+  }
+  e.d_result = result;
+  e.d_lastUse = ++d_clock;
+  if (d_entries.size() > s_maxEntries)
+  {
+    evict(s_maxEntries - s_maxEntries / 4);
+  }
+}
+
+bool InstCache::isDead(const Entry& e)
+{
+  // a term of the context with a single reference is only referenced by this
+  // entry, hence the context is unlikely to occur again
+  for (size_t i = 1, nkey = e.d_key.size(); i < nkey; i++)
+  {
+    if (e.d_key[i].getValue()->d_rc <= 1)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void InstCache::evict(size_t target)
+{
+  std::unordered_multimap<size_t, Entry>::iterator it;
+  for (it = d_entries.begin(); it != d_entries.end();)
+  {
+    if (isDead(it->second))
+    {
+      it = d_entries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  if (d_entries.size() <= target)
+  {
+    return;
+  }
+  // evict the least recently used entries
+  std::vector<uint64_t> uses;
+  uses.reserve(d_entries.size());
+  for (const std::pair<const size_t, Entry>& e : d_entries)
+  {
+    uses.push_back(e.second.d_lastUse);
+  }
+  size_t nevict = d_entries.size() - target;
+  std::nth_element(uses.begin(), uses.begin() + (nevict - 1), uses.end());
+  uint64_t cutoff = uses[nevict - 1];
+  for (it = d_entries.begin(); it != d_entries.end();)
+  {
+    if (it->second.d_lastUse <= cutoff)
+    {
+      it = d_entries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+}  // namespace ethos
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef INST_CACHE_H
+#define INST_CACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "expr.h"
+
+namespace ethos {
+
+/**
+ * A cache of the instantiations of types under contexts, which is used for
+ * the conclusions of proof rules.
+ *
+ * An instantiation is keyed by the type and the entries of the context, in
+ * order. The cache holds a reference to each term in its keys and values.
+ * Since the number of distinct contexts grows with the size of the proof,
+ * entries are evicted when it exceeds s_maxEntries, in the same manner as in
+ * ProgramMemo.
+ */
+class InstCache
+{
+ public:
+  InstCache();
+  ~InstCache();
+  /**
+   * Get the instantiation of type under ctx. Returns false if it is not in
+   * the cache.
+   */
+  bool find(ExprValue* type, const Ctx& ctx, Expr& result);
+  /**
+   * Set the instantiation of type under ctx to result, evicting entries if
+   * the number of entries exceeds s_maxEntries.
+   */
+  void insert(ExprValue* type, const Ctx& ctx, const Expr& result);
+  /** Get the number of entries */
+  size_t size() const { return d_entries.size(); }
+
+ private:
+  /** The maximum number of entries */
+  static const size_t s_maxEntries = 1 << 16;
+  /** An entry of the cache */
+  class Entry
+  {
+   public:
+    /** The terms in the key, which the cache holds a reference to */
+    std::vector<Expr> d_key;
+    /** The instantiation */
+    Expr d_result;
+    /** The last time this entry was used */
+    uint64_t d_lastUse;
+  };
+  /** Set d_scratch to the key for type and ctx, return its hash */
+  size_t mkKey(ExprValue* type, const Ctx& ctx);
+  /** Does entry e have key d_scratch? */
+  bool hasScratchKey(const Entry& e) const;
+  /** Is entry e only relevant to terms held by this cache? */
+  static bool isDead(const Entry& e);
+  /** Evict entries until at most target remain */
+  void evict(size_t target);
+  /** The clock, incremented on each use of an entry */
+  uint64_t d_clock;
+  /** The key of the current lookup */
+  std::vector<ExprValue*> d_scratch;
+  /** The entries, indexed by the hash of their key */
+  std::unordered_multimap<size_t, Entry> d_entries;
+};
+
+}  // namespace ethos
+
+#endif /* INST_CACHE_H */
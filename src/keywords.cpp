@@ -0,0 +1,167 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "keywords.h"
+
+namespace ethos {
+
+namespace {
+
+using Category = Keyword::Category;
+
+constexpr Keyword mkCommand(std::string_view name, Category c, Token t)
+{
+  return Keyword{name, c, t, Attr::NONE, Kind::NONE};
+}
+
+constexpr Keyword mkAttr(std::string_view name, Attr a)
+{
+  return Keyword{name, Category::ATTRIBUTE, Token::NONE, a, Kind::NONE};
+}
+
+constexpr Keyword mkLiteralKind(std::string_view name, Kind k)
+{
+  return Keyword{name, Category::LITERAL_KIND, Token::NONE, Attr::NONE, k};
+}
+
+/** The reserved words */
+constexpr Keyword s_keywords[] = {
+    // commands supported in both inputs and proofs
+    mkCommand("declare-codatatype", Category::COMMAND, Token::DECLARE_CODATATYPE),  // undocumented, TODO: remove
+    mkCommand("declare-codatatypes", Category::COMMAND, Token::DECLARE_CODATATYPES),  // undocumented, TODO: remove
+    mkCommand("declare-const", Category::COMMAND, Token::DECLARE_CONST),
+    mkCommand("declare-datatype", Category::COMMAND, Token::DECLARE_DATATYPE),
+    mkCommand("declare-datatypes", Category::COMMAND, Token::DECLARE_DATATYPES),
+    mkCommand("echo", Category::COMMAND, Token::ECHO),
+    mkCommand("exit", Category::COMMAND, Token::EXIT),
+    mkCommand("set-option", Category::COMMAND, Token::SET_OPTION),
+    mkCommand("pop", Category::COMMAND, Token::POP),    // undocumented
+    mkCommand("push", Category::COMMAND, Token::PUSH),  // undocumented
+    mkCommand("reset", Category::COMMAND, Token::RESET),
+    // only used in smt2 queries
+    mkCommand("assert", Category::COMMAND_REFERENCE, Token::ASSERT),
+    mkCommand("declare-fun", Category::COMMAND_REFERENCE, Token::DECLARE_FUN),
+    mkCommand("declare-sort", Category::COMMAND_REFERENCE, Token::DECLARE_SORT),
+    mkCommand("define-const", Category::COMMAND_REFERENCE, Token::DEFINE_CONST),
+    mkCommand("define-fun", Category::COMMAND_REFERENCE, Token::DEFINE_FUN),
+    mkCommand("define-sort", Category::COMMAND_REFERENCE, Token::DEFINE_SORT),
+    mkCommand("check-sat", Category::COMMAND_REFERENCE, Token::CHECK_SAT),
+    mkCommand("check-sat-assuming", Category::COMMAND_REFERENCE, Token::CHECK_SAT_ASSUMING),
+    mkCommand("set-logic", Category::COMMAND_REFERENCE, Token::SET_LOGIC),
+    mkCommand("set-info", Category::COMMAND_REFERENCE, Token::SET_INFO),
+    // only used in proofs and signatures
+    mkCommand("assume", Category::COMMAND_EO, Token::ASSUME),
+    mkCommand("assume-push", Category::COMMAND_EO, Token::ASSUME_PUSH),
+    mkCommand("declare-consts", Category::COMMAND_EO, Token::DECLARE_CONSTS),
+    mkCommand("declare-oracle-fun", Category::COMMAND_EO, Token::DECLARE_ORACLE_FUN),
+    mkCommand("declare-parameterized-const", Category::COMMAND_EO, Token::DECLARE_PARAMETERIZED_CONST),
+    mkCommand("declare-rule", Category::COMMAND_EO, Token::DECLARE_RULE),
+    mkCommand("declare-type", Category::COMMAND_EO, Token::DECLARE_TYPE),
+    mkCommand("define", Category::COMMAND_EO, Token::DEFINE),
+    mkCommand("define-type", Category::COMMAND_EO, Token::DEFINE_TYPE),
+    mkCommand("include", Category::COMMAND_EO, Token::INCLUDE),
+    mkCommand("program", Category::COMMAND_EO, Token::PROGRAM),
+    mkCommand("reference", Category::COMMAND_EO, Token::REFERENCE),
+    mkCommand("step", Category::COMMAND_EO, Token::STEP),
+    mkCommand("step-pop", Category::COMMAND_EO, Token::STEP_POP),
+    // attributes
+    mkAttr(":var", Attr::VAR),
+    mkAttr(":implicit", Attr::IMPLICIT),
+    mkAttr(":type", Attr::TYPE),
+    mkAttr(":list", Attr::LIST),
+    mkAttr(":requires", Attr::REQUIRES),
+    mkAttr(":left-assoc", Attr::LEFT_ASSOC),
+    mkAttr(":right-assoc", Attr::RIGHT_ASSOC),
+    mkAttr(":left-assoc-nil", Attr::LEFT_ASSOC_NIL),
+    mkAttr(":right-assoc-nil", Attr::RIGHT_ASSOC_NIL),
+    mkAttr(":chainable", Attr::CHAINABLE),
+    mkAttr(":pairwise", Attr::PAIRWISE),
+    mkAttr(":binder", Attr::BINDER),
+    mkAttr(":let-binder", Attr::LET_BINDER),
+    mkAttr(":opaque", Attr::OPAQUE),
+    mkAttr(":syntax", Attr::SYNTAX),
+    mkAttr(":restrict", Attr::RESTRICT),
+    mkAttr(":sorry", Attr::SORRY),
+    // literal kinds
+    mkLiteralKind("<boolean>", Kind::BOOLEAN),
+    mkLiteralKind("<numeral>", Kind::NUMERAL),
+    mkLiteralKind("<decimal>", Kind::DECIMAL),
+    mkLiteralKind("<rational>", Kind::RATIONAL),
+    mkLiteralKind("<hexadecimal>", Kind::HEXADECIMAL),
+    mkLiteralKind("<binary>", Kind::BINARY),
+    mkLiteralKind("<string>", Kind::STRING),
+};
+
+constexpr size_t s_numKeywords = sizeof(s_keywords) / sizeof(s_keywords[0]);
+
+/** The number of slots in the hash table, which must be a power of two */
+constexpr size_t s_tableSize = 512;
+
+static_assert(s_numKeywords < 256, "slots of the hash table are bytes");
+
+/** The 32-bit FNV-1a hash of name, starting from seed */
+constexpr uint32_t hashName(std::string_view name, uint32_t seed)
+{
+  uint32_t h = seed;
+  for (char c : name)
+  {
+    h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return h;
+}
+
+/**
+ * The hash table, whose slots store one plus the index of the reserved word
+ * that hashes to it, or zero if none does.
+ */
+struct Table
+{
+  uint32_t d_seed;
+  uint8_t d_slots[s_tableSize];
+};
+
+/** Find a seed for which no two reserved words hash to the same slot */
+constexpr Table mkTable()
+{
+  Table t{};
+  for (uint32_t seed = 2166136261u;; seed++)
+  {
+    for (size_t i = 0; i < s_tableSize; i++)
+    {
+      t.d_slots[i] = 0;
+    }
+    bool collision = false;
+    for (size_t i = 0; i < s_numKeywords && !collision; i++)
+    {
+      uint32_t slot = hashName(s_keywords[i].d_name, seed) & (s_tableSize - 1);
+      collision = (t.d_slots[slot] != 0);
+      t.d_slots[slot] = static_cast<uint8_t>(i + 1);
+    }
+    if (!collision)
+    {
+      t.d_seed = seed;
+      return t;
+    }
+  }
+}
+
+constexpr Table s_table = mkTable();
+
+}  // namespace
+
+const Keyword* Keyword::find(std::string_view name)
+{
+  uint8_t i = s_table.d_slots[hashName(name, s_table.d_seed) & (s_tableSize - 1)];
+  if (i == 0 || s_keywords[i - 1].d_name != name)
+  {
+    return nullptr;
+  }
+  return &s_keywords[i - 1];
+}
+
+}  // namespace ethos
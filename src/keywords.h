@@ -0,0 +1,61 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "attr.h"
+#include "kind.h"
+#include "tokens.h"
+
+namespace ethos {
+
+/**
+ * A reserved word of the input language, i.e. the name of a command, an
+ * attribute keyword or the name of a literal kind.
+ *
+ * Reserved words are recognized by a perfect hash whose table is computed at
+ * compile time, so that the parsers can look up the current token of the
+ * lexer without copying it.
+ */
+class Keyword
+{
+ public:
+  enum class Category : uint8_t
+  {
+    /** A command supported in both proofs and reference files */
+    COMMAND,
+    /** A command supported only in reference files */
+    COMMAND_REFERENCE,
+    /** A command supported only in proofs and signatures */
+    COMMAND_EO,
+    /** An attribute keyword, including the leading colon */
+    ATTRIBUTE,
+    /** The name of a literal kind, e.g. <numeral> */
+    LITERAL_KIND
+  };
+  /** The name */
+  std::string_view d_name;
+  /** The category */
+  Category d_category;
+  /** The token, if a command */
+  Token d_token;
+  /** The attribute, if an attribute keyword */
+  Attr d_attr;
+  /** The kind, if a literal kind */
+  Kind d_kind;
+  /** Get the reserved word with the given name, or nullptr if none exists. */
+  static const Keyword* find(std::string_view name);
+};
+
+}  // namespace ethos
+
+#endif /* KEYWORDS_H */
@@ -287,4 +287,16 @@ bool isListLiteralOp(Kind k)
   return false;
 }
 
+bool isNonCurriedSymbol(Kind k)
+{
+  switch (k)
+  {
+    case Kind::PROGRAM_CONST:
+    case Kind::PROOF_RULE:
+    case Kind::ORACLE: return true; break;
+    default: break;
+  }
+  return false;
+}
+
 }  // namespace ethos
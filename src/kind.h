@@ -120,6 +120,11 @@ bool isLiteral(Kind k);
 bool isLiteralOp(Kind k);
 /** Is k a list literal operator? */
 bool isListLiteralOp(Kind k);
+/**
+ * Is k the kind of a symbol whose applications are not curried, i.e. a
+ * program, proof rule or oracle?
+ */
+bool isNonCurriedSymbol(Kind k);
 
 }  // namespace ethos
 
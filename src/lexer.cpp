@@ -9,10 +9,16 @@
 #include "lexer.h"
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "base/check.h"
+#include "token_pipeline.h"
 
 namespace ethos {
 
@@ -26,8 +32,19 @@ std::ostream& operator<<(std::ostream& o, const Span& l)
 }
 
 Lexer::Lexer(bool lexLet)
-    : d_lexLet(lexLet), d_isInteractive(false), d_bufferPos(0), d_bufferEnd(0),
-      d_peekedChar(false), d_chPeeked(0)
+    : d_istream(nullptr),
+      d_lexLet(lexLet),
+      d_isInteractive(false),
+      d_inMemory(false),
+      d_data(d_buffer),
+      d_bufferPos(0),
+      d_bufferEnd(0),
+      d_deferErrors(false),
+      d_peekedChar(false),
+      d_chPeeked(0),
+      d_tokenBegin(0),
+      d_tokenEnd(0),
+      d_hasTokenCopy(false)
 {
   for (int32_t ch = 'a'; ch <= 'z'; ++ch)
   {
@@ -70,6 +87,8 @@ Lexer::Lexer(bool lexLet)
   d_charClass['\n'] |= static_cast<uint32_t>(CharacterClass::WHITESPACE);
 }
 
+Lexer::~Lexer() {}
+
 void Lexer::warning(const std::string& msg)
 {
   std::cout << d_inputName << ':' << d_span.d_start.d_line << '.'
@@ -96,16 +115,39 @@ void Lexer::initSpan()
   d_span.d_end.d_column = 0;
 }
 
-void Lexer::initialize(Input* input, const std::string& inputName)
+void Lexer::initialize(Input* input,
+                       const std::string& inputName,
+                       bool pipelined)
 {
   Assert(input != nullptr);
-  d_istream = input->getStream();
-  d_isInteractive = input->isInteractive();
   d_inputName = inputName;
   initSpan();
   d_peeked.clear();
+  // stop the current pipeline, if any
+  d_pipeline.reset();
+  if (pipelined)
+  {
+    d_pipeline.reset(new TokenPipeline(input, inputName, d_lexLet));
+    return;
+  }
   d_bufferPos = 0;
-  d_bufferEnd = 0;
+  const char* data = input->getData();
+  d_inMemory = (data != nullptr);
+  if (d_inMemory)
+  {
+    // we lex the contents directly
+    d_istream = nullptr;
+    d_isInteractive = false;
+    d_data = data;
+    d_bufferEnd = input->getSize();
+  }
+  else
+  {
+    d_istream = input->getStream();
+    d_isInteractive = input->isInteractive();
+    d_data = d_buffer;
+    d_bufferEnd = 0;
+  }
   d_peekedChar = false;
   d_chPeeked = 0;
 }
@@ -176,12 +218,49 @@ bool Lexer::eatTokenChoice(Token t, Token f)
 
 const char* Lexer::tokenStr() const
 {
+  if (d_pipeline != nullptr || d_inMemory)
+  {
+    // copy the token, since the input is not null terminated after it
+    if (!d_hasTokenCopy)
+    {
+      d_tokenCopy.assign(getCurrentToken());
+      d_hasTokenCopy = true;
+    }
+    return d_tokenCopy.c_str();
+  }
   Assert(!d_token.empty() && d_token.back() == 0);
   return d_token.data();
 }
 
+std::string_view Lexer::tokenView() const
+{
+  if (d_pipeline != nullptr || d_inMemory)
+  {
+    return getCurrentToken();
+  }
+  Assert(!d_token.empty() && d_token.back() == 0);
+  return std::string_view(d_token.data(), d_token.size() - 1);
+}
+
 Token Lexer::nextTokenInternal()
 {
+  if (d_pipeline != nullptr)
+  {
+    d_hasTokenCopy = false;
+    Token t = d_pipeline->nextToken(d_span, d_pipelineToken);
+    if (t == Token::NONE)
+    {
+      // an error found when lexing ahead
+      parseError(d_pipeline->getError());
+    }
+    return t;
+  }
+  if (d_inMemory)
+  {
+    d_tokenBegin = d_tokenEnd = d_bufferPos;
+    d_hasTokenCopy = false;
+    return computeNextToken();
+  }
   d_token.clear();
   Token ret = computeNextToken();
   // null terminate?
@@ -196,27 +275,35 @@ Token Lexer::computeNextToken()
   // skip whitespace and comments
   for (;;)
   {
-    do
+    if ((ch = nextChar()) == EOF)
+    {
+      return Token::EOF_TOK;
+    }
+    if (isCharacterClass(ch, CharacterClass::WHITESPACE))
     {
-      if ((ch = nextChar()) == EOF)
+      // skip the rest of the whitespace in the buffer at once
+      if (d_bufferPos < d_bufferEnd
+          && isCharacterClass(d_data[d_bufferPos], CharacterClass::WHITESPACE))
       {
-        return Token::EOF_TOK;
+        skipWhitespace();
       }
-    } while (isCharacterClass(ch, CharacterClass::WHITESPACE));
-
+      continue;
+    }
     if (ch != ';')
     {
       break;
     }
-    while ((ch = nextChar()) != '\n')
+    if (!skipComment())
     {
-      if (ch == EOF)
-      {
-        return Token::EOF_TOK;
-      }
+      return Token::EOF_TOK;
     }
   }
   bumpSpan();
+  if (d_inMemory)
+  {
+    // the token starts with the character we read last
+    d_tokenBegin = d_bufferPos - 1;
+  }
   pushToToken(ch);
   switch (ch)
   {
@@ -249,8 +336,7 @@ Token Lexer::computeNextToken()
           return Token::HEX_LITERAL;
         default:
           // otherwise error
-          parseError("Error finding token following #");
-          break;
+          return lexError("Error finding token following #");
       }
       break;
     case '"':
@@ -279,7 +365,7 @@ Token Lexer::computeNextToken()
       // parse a simple symbol
       if (!parseChar(CharacterClass::SYMBOL_START))
       {
-        parseError("Error expected symbol following :");
+        return lexError("Error expected symbol following :");
       }
       parseNonEmptyCharList(CharacterClass::SYMBOL);
       return Token::KEYWORD;
@@ -298,7 +384,7 @@ Token Lexer::computeNextToken()
           // parse [0-9]+
           if (!parseNonEmptyCharList(CharacterClass::DECIMAL_DIGIT))
           {
-            parseError("Error expected decimal string following .");
+            return lexError("Error expected decimal string following .");
           }
         }
         else
@@ -319,7 +405,16 @@ Token Lexer::computeNextToken()
       // otherwise error
       break;
   }
-  parseError("Error finding token");
+  return lexError("Error finding token");
+}
+
+Token Lexer::lexError(const std::string& msg)
+{
+  if (!d_deferErrors)
+  {
+    parseError(msg);
+  }
+  d_error = msg;
   return Token::NONE;
 }
 
@@ -366,6 +461,30 @@ void Lexer::parseCharList(CharacterClass cc)
   int32_t ch;
   for (;;)
   {
+    if (!d_peekedChar)
+    {
+      // consume the characters from cc in the buffer at once, which does not
+      // include newlines
+      size_t pos = d_bufferPos;
+      while (pos < d_bufferEnd && isCharacterClass(d_data[pos], cc))
+      {
+        pos++;
+      }
+      if (pos > d_bufferPos)
+      {
+        if (d_inMemory)
+        {
+          d_tokenEnd = pos;
+        }
+        else
+        {
+          d_token.insert(
+              d_token.end(), d_data + d_bufferPos, d_data + pos);
+        }
+        addColumns(static_cast<uint32_t>(pos - d_bufferPos));
+        d_bufferPos = pos;
+      }
+    }
     ch = nextChar();
     if (!isCharacterClass(ch, cc))
     {
@@ -377,37 +496,125 @@ void Lexer::parseCharList(CharacterClass cc)
   }
 }
 
+void Lexer::skipWhitespace()
+{
+  size_t pos = d_bufferPos;
+  size_t lines = 0;
+  // the position after the last newline, if lines>0
+  size_t lineStart = 0;
+#ifdef __SSE2__
+  // scan 16 characters at a time
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i nl = _mm_set1_epi8('\n');
+  while (pos + 16 <= d_bufferEnd)
+  {
+    __m128i c =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(d_data + pos));
+    __m128i isNl = _mm_cmpeq_epi8(c, nl);
+    __m128i isWs = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(c, space), _mm_cmpeq_epi8(c, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(c, cr), isNl));
+    uint32_t notWs = ~static_cast<uint32_t>(_mm_movemask_epi8(isWs)) & 0xffff;
+    uint32_t len = notWs == 0 ? 16 : __builtin_ctz(notWs);
+    uint32_t nls =
+        static_cast<uint32_t>(_mm_movemask_epi8(isNl)) & ((1u << len) - 1);
+    if (nls != 0)
+    {
+      lines += __builtin_popcount(nls);
+      lineStart = pos + (32 - __builtin_clz(nls));
+    }
+    pos += len;
+    if (len < 16)
+    {
+      break;
+    }
+  }
+#endif
+  while (pos < d_bufferEnd
+         && isCharacterClass(d_data[pos], CharacterClass::WHITESPACE))
+  {
+    if (d_data[pos] == '\n')
+    {
+      lines++;
+      lineStart = pos + 1;
+    }
+    pos++;
+  }
+  if (lines > 0)
+  {
+    addLines(static_cast<uint32_t>(lines));
+    addColumns(static_cast<uint32_t>(pos - lineStart));
+  }
+  else
+  {
+    addColumns(static_cast<uint32_t>(pos - d_bufferPos));
+  }
+  d_bufferPos = pos;
+}
+
+bool Lexer::skipComment()
+{
+  for (;;)
+  {
+    const char* start = d_data + d_bufferPos;
+    const char* end = static_cast<const char*>(
+        std::memchr(start, '\n', d_bufferEnd - d_bufferPos));
+    if (end != nullptr)
+    {
+      addColumns(static_cast<uint32_t>(end - start));
+      addLines(1);
+      d_bufferPos = static_cast<size_t>(end - d_data) + 1;
+      return true;
+    }
+    addColumns(static_cast<uint32_t>(d_bufferEnd - d_bufferPos));
+    d_bufferPos = d_bufferEnd;
+    // read past the end of the buffer
+    int32_t ch = nextChar();
+    if (ch == EOF)
+    {
+      return false;
+    }
+    else if (ch == '\n')
+    {
+      return true;
+    }
+  }
+}
+
 Token Lexer::tokenizeCurrentSymbol() const
 {
-  Assert(!d_token.empty());
-  switch (d_token[0])
+  std::string_view token = getCurrentToken();
+  Assert(!token.empty());
+  switch (token[0])
   {
     case '!':
-      if (d_token.size()==1)
+      if (token.size()==1)
       {
         return Token::ATTRIBUTE;
       }
       break;
     case '-':
     {
-      if (d_token.size()>=2)
+      if (token.size()>=2)
       {
         // reparse as a negative numeral, rational or decimal
         Token ret = Token::INTEGER_LITERAL;
-        for (size_t i=1, tsize = d_token.size(); i<tsize; i++)
+        for (size_t i=1, tsize = token.size(); i<tsize; i++)
         {
-          if (isCharacterClass(d_token[i], CharacterClass::DECIMAL_DIGIT))
+          if (isCharacterClass(token[i], CharacterClass::DECIMAL_DIGIT))
           {
             continue;
           }
           else if (i+1<tsize && ret==Token::INTEGER_LITERAL)
           {
-            if (d_token[i]=='.')
+            if (token[i]=='.')
             {
               ret = Token::DECIMAL_LITERAL;
               continue;
             }
-            else if (d_token[i]=='/')
+            else if (token[i]=='/')
             {
               ret = Token::RATIONAL_LITERAL;
               continue;
@@ -420,17 +627,17 @@ Token Lexer::tokenizeCurrentSymbol() const
     }
       break;
     case 'e':
-      if (d_token.size()>=4 && d_token[1] == 'o' && d_token[2] == ':' && d_token[3] == ':')
+      if (token.size()>=4 && token[1] == 'o' && token[2] == ':' && token[3] == ':')
       {
-        if (d_token.size()==9 && d_token[4]=='m' && d_token[5]=='a' &&
-            d_token[6]=='t' && d_token[7]=='c' && d_token[8]=='h')
+        if (token.size()==9 && token[4]=='m' && token[5]=='a' &&
+            token[6]=='t' && token[7]=='c' && token[8]=='h')
         {
           // eo::match
           return Token::EVAL_MATCH;
         }
-        else if (d_token.size()==10 && d_token[4]=='d' && d_token[5]=='e' &&
-                 d_token[6]=='f' && d_token[7]=='i' && d_token[8]=='n' &&
-                 d_token[9]=='e')
+        else if (token.size()==10 && token[4]=='d' && token[5]=='e' &&
+                 token[6]=='f' && token[7]=='i' && token[8]=='n' &&
+                 token[9]=='e')
         {
           // eo::define
           return Token::EVAL_DEFINE;
@@ -438,26 +645,26 @@ Token Lexer::tokenizeCurrentSymbol() const
       }
       break;
     case 'p':
-      if (d_token.size() == 3 && d_token[1] == 'a' && d_token[2] == 'r')
+      if (token.size() == 3 && token[1] == 'a' && token[2] == 'r')
       {
         return Token::PAR;
       }
       break;
     case 'l':
       // only lex let if option is true (d_lexLet)
-      if (d_lexLet && d_token.size() == 3 && d_token[1] == 'e' && d_token[2] == 't')
+      if (d_lexLet && token.size() == 3 && token[1] == 'e' && token[2] == 't')
       {
         return Token::LET;
       }
       break;
     case 'B':
-      if (d_token.size() == 4 && d_token[1] == 'o' && d_token[2] == 'o' && d_token[3] == 'l')
+      if (token.size() == 4 && token[1] == 'o' && token[2] == 'o' && token[3] == 'l')
       {
         return Token::BOOL_TYPE;
       }
       break;
     case 'T':
-      if (d_token.size() == 4 && d_token[1] == 'y' && d_token[2] == 'p' && d_token[3] == 'e')
+      if (token.size() == 4 && token[1] == 'y' && token[2] == 'p' && token[3] == 'e')
       {
         return Token::TYPE;
       }
@@ -12,7 +12,9 @@
 #include <array>
 #include <fstream>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "base/check.h"
@@ -40,24 +42,34 @@ std::ostream& operator<<(std::ostream& o, const Span& l);
 
 #define INPUT_BUFFER_SIZE 32768
 
+class TokenPipeline;
+
 /**
  */
 class Lexer
 {
+  friend class TokenPipeline;
+
  public:
   Lexer(bool lexLet);
-  virtual ~Lexer() {}
+  virtual ~Lexer();
   /**
    * Initialize the lexer to generate tokens from stream input.
    * @param input The input stream
    * @param inputName The name for debugging
+   * @param pipelined Whether the input is lexed on a separate thread, ahead
+   * of the calls to nextToken
    */
-  void initialize(Input* input, const std::string& inputName);
+  void initialize(Input* input,
+                  const std::string& inputName,
+                  bool pipelined = false);
   /**
    * String corresponding to the last token (old top of stack). This is only
    * valid if no tokens are currently peeked.
    */
   const char* tokenStr() const;
+  /** Same as tokenStr, but returns a view that excludes the null terminator */
+  std::string_view tokenView() const;
   /** Advance to the next token (pop from stack) */
   Token nextToken();
   /** Add a token back into the stream (push to stack) */
@@ -87,17 +99,24 @@ class Lexer
   {
     if (d_bufferPos < d_bufferEnd)
     {
-      d_ch = d_buffer[d_bufferPos];
+      d_ch = d_data[d_bufferPos];
       d_bufferPos++;
     }
+    else if (d_inMemory)
+    {
+      d_ch = EOF;
+    }
     else if (d_isInteractive)
     {
       d_ch = d_istream->get();
     }
     else
     {
-      d_istream->read(d_buffer, INPUT_BUFFER_SIZE);
-      d_bufferEnd = static_cast<size_t>(d_istream->gcount());
+      // read from the stream buffer directly, which may return fewer
+      // characters than requested if the rest of the input is not yet
+      // available, e.g. for piped input
+      d_bufferEnd = static_cast<size_t>(
+          d_istream->rdbuf()->sgetn(d_buffer, INPUT_BUFFER_SIZE));
       if (d_bufferEnd == 0)
       {
         d_ch = EOF;
@@ -170,13 +189,20 @@ class Lexer
   std::vector<Token> d_peeked;
 
  private:
-  /** The input */
+  /** The input stream, if the input is not in memory */
   std::istream* d_istream;
   /** Are we lexing "let"? */
   bool d_lexLet;
   /** True if the input stream is interactive */
   bool d_isInteractive;
-  /** The current buffer */
+  /**
+   * True if the contents of the input are in memory, in which case d_data is
+   * the entire input, and tokens are ranges of it.
+   */
+  bool d_inMemory;
+  /** The characters we are reading from, either the input or d_buffer */
+  const char* d_data;
+  /** The buffer for reading from the input stream */
   char d_buffer[INPUT_BUFFER_SIZE];
   /** The position in the current buffer we are reading from */
   size_t d_bufferPos;
@@ -184,20 +210,57 @@ class Lexer
   size_t d_bufferEnd;
   /** The current character we read. */
   int32_t d_ch;
+  /**
+   * True if errors are not reported by parseError, in which case the error
+   * message is stored in d_error and Token::NONE is returned as the token.
+   */
+  bool d_deferErrors;
+  /** The last error, if d_deferErrors is true */
+  std::string d_error;
+  /** Report error msg, return Token::NONE */
+  Token lexError(const std::string& msg);
+  /** The pipeline computing our tokens, if the input is pipelined */
+  std::unique_ptr<TokenPipeline> d_pipeline;
+  /** The current token, if the input is pipelined */
+  std::string_view d_pipelineToken;
   /** True if we have a saved character that has not been consumed yet. */
   bool d_peekedChar;
   /** The saved character. */
   int32_t d_chPeeked;
   /**
-   * Computes the next token and adds its characters to d_token. Does not
-   * null terminate.
+   * Computes the next token and adds its characters to the current token.
+   * Does not null terminate.
    */
   Token computeNextToken();
-  /** Push a character to the stored token */
+  /**
+   * Push a character to the stored token, which must be the character we
+   * read last.
+   */
   void pushToToken(int32_t ch)
   {
     Assert(ch != EOF);
-    d_token.push_back(static_cast<char>(ch));
+    if (d_inMemory)
+    {
+      // the token extends to the current character
+      d_tokenEnd = d_bufferPos;
+    }
+    else
+    {
+      d_token.push_back(static_cast<char>(ch));
+    }
+  }
+  /** Get the characters of the current token, which is not null terminated */
+  std::string_view getCurrentToken() const
+  {
+    if (d_pipeline != nullptr)
+    {
+      return d_pipelineToken;
+    }
+    if (d_inMemory)
+    {
+      return std::string_view(d_data + d_tokenBegin, d_tokenEnd - d_tokenBegin);
+    }
+    return std::string_view(d_token.data(), d_token.size());
   }
   //----------- Utilities for parsing the current character stream
   enum class CharacterClass
@@ -220,6 +283,16 @@ class Lexer
   bool parseNonEmptyCharList(CharacterClass cc);
   /** parse <c>* from cc. */
   void parseCharList(CharacterClass cc);
+  /**
+   * Skip the whitespace at the current position of the buffer, which follows
+   * a whitespace character we read last.
+   */
+  void skipWhitespace();
+  /**
+   * Skip the remainder of a comment, up to and including the end of the line.
+   * Return false if we reach the end of the input.
+   */
+  bool skipComment();
   /** Return true if ch is in character class cc */
   bool isCharacterClass(int32_t ch, CharacterClass cc) const
   {
@@ -229,7 +302,7 @@ class Lexer
   /**
    * Tokenize current symbol stored in d_token.
    *
-   * This method changes the string in d_token into the appropriate token.
+   * This method changes the current token into the appropriate token.
    * Otherwise, we return Token::SYMBOL.
    *
    * The list of all simple symbols that are converted by this method.
@@ -238,8 +311,18 @@ class Lexer
    * We don't handle command tokens here.
    */
   Token tokenizeCurrentSymbol() const;
-  /** The characters in the current token */
+  /** The characters in the current token, if the input is not in memory */
   std::vector<char> d_token;
+  /** The range of the current token in d_data, if the input is in memory */
+  size_t d_tokenBegin;
+  size_t d_tokenEnd;
+  /**
+   * A null terminated copy of the current token, if the input is in memory,
+   * which is computed by tokenStr.
+   */
+  mutable std::string d_tokenCopy;
+  /** Whether d_tokenCopy is the current token */
+  mutable bool d_hasTokenCopy;
   /** The character classes. */
   std::array<uint8_t, 256> d_charClass{};  // value-initialized to 0
 };
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "list_cache.h"
+
+#include <algorithm>
+
+namespace ethos {
+
+ListView::ListView(ExprValue* op) : d_op(op), d_tail(nullptr) {}
+
+size_t ListView::find(const ExprValue* a)
+{
+  if (d_elements.size() <= s_hashThreshold)
+  {
+    return std::distance(
+        d_elements.begin(),
+        std::find(d_elements.begin(), d_elements.end(), a));
+  }
+  if (d_index.empty())
+  {
+    for (size_t i = 0, nelems = d_elements.size(); i < nelems; i++)
+    {
+      d_index.emplace(d_elements[i], i);
+    }
+  }
+  std::unordered_map<const ExprValue*, size_t>::iterator it = d_index.find(a);
+  return it == d_index.end() ? d_elements.size() : it->second;
+}
+
+ListCache::ListCache() {}
+
+ListCache::~ListCache() {}
+
+ExprValue* ListCache::getNext(ExprValue* e,
+                              const ExprValue* op,
+                              bool isLeft,
+                              ExprValue*& elem)
+{
+  if (e->getKind() != Kind::APPLY)
+  {
+    return nullptr;
+  }
+  ExprValue* cop = (*e)[0];
+  if (e->getNumChildren() == 3)
+  {
+    // an n-ary application (op a b)
+    if (cop != op)
+    {
+      return nullptr;
+    }
+    elem = isLeft ? (*e)[2] : (*e)[1];
+    return isLeft ? (*e)[1] : (*e)[2];
+  }
+  // a curried application ((op a) b)
+  if (cop->getKind() != Kind::APPLY || (*cop)[0] != op)
+  {
+    return nullptr;
+  }
+  elem = isLeft ? (*e)[1] : (*cop)[1];
+  return isLeft ? (*cop)[1] : (*e)[1];
+}
+
+ExprValue* ListCache::getTail(ExprValue* e,
+                              ExprValue* op,
+                              bool isLeft,
+                              size_t& length)
+{
+  // traverse the spine until we find a term whose information is cached
+  ExprValue* tail = e;
+  ExprValue* next;
+  ExprValue* elem;
+  length = 0;
+  while ((next = getNext(tail, op, isLeft, elem)) != nullptr)
+  {
+    std::unordered_map<const ExprValue*, Spine>::iterator it =
+        d_spines.find(tail);
+    if (it != d_spines.end())
+    {
+      length = it->second.d_length;
+      tail = it->second.d_tail;
+      break;
+    }
+    d_visit.push_back(tail);
+    tail = next;
+  }
+  // cache the information for the terms we traversed
+  while (!d_visit.empty())
+  {
+    ExprValue* v = d_visit.back();
+    d_visit.pop_back();
+    length++;
+    Spine& s = d_spines[v];
+    s.d_op = op;
+    s.d_tail = tail;
+    s.d_length = length;
+    v->setFlag(ExprValue::Flag::HAS_LIST_CACHE, true);
+  }
+  return tail;
+}
+
+ListView& ListCache::getView(ExprValue* e, ExprValue* op, bool isLeft)
+{
+  std::unordered_map<const ExprValue*, ListView>::iterator it =
+      d_views.find(e);
+  if (it != d_views.end() && it->second.d_op == op)
+  {
+    return it->second;
+  }
+  if (it != d_views.end())
+  {
+    d_views.erase(it);
+  }
+  ListView& v = d_views.emplace(e, ListView(op)).first->second;
+  ExprValue* tail = e;
+  ExprValue* next;
+  ExprValue* elem;
+  while ((next = getNext(tail, op, isLeft, elem)) != nullptr)
+  {
+    v.d_elements.push_back(elem);
+    tail = next;
+  }
+  v.d_tail = tail;
+  e->setFlag(ExprValue::Flag::HAS_LIST_CACHE, true);
+  return v;
+}
+
+ListView* ListCache::findView(const ExprValue* e, const ExprValue* op)
+{
+  std::unordered_map<const ExprValue*, ListView>::iterator it =
+      d_views.find(e);
+  if (it != d_views.end() && it->second.d_op == op)
+  {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+void ListCache::erase(const ExprValue* e)
+{
+  d_spines.erase(e);
+  d_views.erase(e);
+}
+
+}  // namespace ethos
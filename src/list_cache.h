@@ -0,0 +1,105 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef LIST_CACHE_H
+#define LIST_CACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "expr.h"
+
+namespace ethos {
+
+/**
+ * A flattened view of an application of an associative operator, which is
+ * used by the list operators e.g. eo::list_nth and eo::list_find.
+ */
+class ListView
+{
+ public:
+  ListView(ExprValue* op);
+  /**
+   * Get the index of the first occurrence of a in the elements, or the number
+   * of elements if a does not occur.
+   */
+  size_t find(const ExprValue* a);
+  /** The operator */
+  ExprValue* d_op;
+  /** The elements, in the order in which they are reached from the root */
+  std::vector<ExprValue*> d_elements;
+  /** The term after the last element, i.e. the nil terminator if a list */
+  ExprValue* d_tail;
+
+ private:
+  /** The number of elements beyond which find uses a hash index */
+  static const size_t s_hashThreshold = 16;
+  /** Maps elements to the index of their first occurrence, computed lazily */
+  std::unordered_map<const ExprValue*, size_t> d_index;
+};
+
+/**
+ * A cache of information about applications of associative operators, so that
+ * the list operators do not traverse the same list each time they are applied
+ * to it.
+ *
+ * For each term on the spine of a list, the cache may store its length and its
+ * tail. For each list that is indexed or searched, it may store a view with an
+ * array of its elements. Entries are keyed by terms, which the cache does not
+ * hold references to. Instead, the entries of a term are removed when it is
+ * deleted.
+ */
+class ListCache
+{
+ public:
+  ListCache();
+  ~ListCache();
+  /**
+   * Get the term after the last element of the op-application e and set length
+   * to its number of elements. If e is in list form, this is a nil
+   * terminator.
+   */
+  ExprValue* getTail(ExprValue* e, ExprValue* op, bool isLeft, size_t& length);
+  /** Get the view of the op-application e, computing it if necessary */
+  ListView& getView(ExprValue* e, ExprValue* op, bool isLeft);
+  /** Get the view of the op-application e, or nullptr if it is not computed */
+  ListView* findView(const ExprValue* e, const ExprValue* op);
+  /** Remove the entries for e, which is being deleted */
+  void erase(const ExprValue* e);
+  /**
+   * If e is an op-application, return its tail and set elem to its first
+   * element. Otherwise, return nullptr.
+   */
+  static ExprValue* getNext(ExprValue* e,
+                            const ExprValue* op,
+                            bool isLeft,
+                            ExprValue*& elem);
+
+ private:
+  /** The information stored for a term on the spine of a list */
+  class Spine
+  {
+   public:
+    /** The operator */
+    ExprValue* d_op;
+    /** The term after the last element */
+    ExprValue* d_tail;
+    /** The number of elements */
+    size_t d_length;
+  };
+  /** The terms visited in getTail */
+  std::vector<ExprValue*> d_visit;
+  /** The spine information */
+  std::unordered_map<const ExprValue*, Spine> d_spines;
+  /** The views */
+  std::unordered_map<const ExprValue*, ListView> d_views;
+};
+
+}  // namespace ethos
+
+#endif /* LIST_CACHE_H */
@@ -16,6 +16,7 @@ namespace ethos {
 Literal::Literal(const Literal& other)
 {
   d_kind = other.d_kind;
+  computeFlags();
   switch (d_kind)
   {
     case Kind::BOOLEAN: d_bool = other.d_bool; break;
@@ -85,6 +86,28 @@ Literal& Literal::operator=(const Literal& other)
   return *this;
 }
 
+Literal::~Literal()
+{
+  switch (d_kind)
+  {
+    case Kind::BOOLEAN:
+    case Kind::NONE: break;
+    case Kind::DECIMAL:
+    case Kind::RATIONAL: d_rat.~Rational(); break;
+    case Kind::NUMERAL: d_int.~Integer(); break;
+    case Kind::HEXADECIMAL:
+    case Kind::BINARY: d_bv.~BitVector(); break;
+    case Kind::STRING: d_str.~String(); break;
+    default:
+    {
+      Assert(isSymbol(d_kind));
+      using std::string;
+      d_sym.~string();
+    }
+    break;
+  }
+}
+
 std::string Literal::toString() const
 {
   switch (d_kind)
@@ -199,7 +222,7 @@ Literal Literal::evaluate(Kind k, const std::vector<const Literal*>& args)
             default: return Literal(); break;
             }
           }
-          return Literal(ka, res);
+          return Literal(res);
         }
           break;
         case Kind::DECIMAL:
@@ -404,7 +427,7 @@ Literal Literal::evaluate(Kind k, const std::vector<const Literal*>& args)
           // character
           if (args[0]->d_str.size()==1)
           {
-            return Literal(Integer(args[0]->d_str.getVec()[0]));
+            return Literal(Integer(args[0]->d_str.getChar(0)));
           }
         }
           break;
@@ -428,7 +451,7 @@ Literal Literal::evaluate(Kind k, const std::vector<const Literal*>& args)
         {
           case Kind::NUMERAL:return Literal(Kind::BINARY, BitVector(size, args[1]->d_int));
           case Kind::HEXADECIMAL:
-          case Kind::BINARY:return Literal(Kind::BINARY, BitVector(size, args[1]->d_bv.getValue()));
+          case Kind::BINARY:return Literal(Kind::BINARY, BitVector(size, args[1]->d_bv));
           default: break;
         }
       }
@@ -468,7 +491,7 @@ Literal Literal::evaluate(Kind k, const std::vector<const Literal*>& args)
           return Literal(args[0]->d_rat>args[1]->d_rat);
         case Kind::HEXADECIMAL:
         case Kind::BINARY:
-          return Literal(args[0]->d_bv.toInteger()>args[1]->d_bv.toInteger());
+          return Literal(args[0]->d_bv.unsignedGreaterThan(args[1]->d_bv));
         default: break;
       }
       break;
@@ -45,9 +45,7 @@ public:
 
   Literal& operator=(const Literal& other);
 
-  ~Literal() {}
-  /** as literal */
-  const Literal* asLiteral() const override { return this; }
+  ~Literal();
   std::string toString() const;
 
   /** Evaluate literal op */
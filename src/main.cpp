@@ -15,6 +15,10 @@
 #include "base/output.h"
 #include "parser.h"
 #include "state.h"
+#ifdef EO_COMPILED_SIGNATURES
+#include "compiler.h"
+#include "executor.h"
+#endif /* EO_COMPILED_SIGNATURES */
 
 using namespace ethos;
 
@@ -60,22 +64,65 @@ int main( int argc, char* argv[] )
       }
       continue;
     }
+    if (arg.compare(0, 17, "--prog-memo-size=") == 0)
+    {
+      std::string size = arg.substr(17);
+      if (size.empty()
+          || size.find_first_not_of("0123456789") != std::string::npos)
+      {
+        EO_FATAL() << "Error: expected a number of entries for " << arg;
+      }
+      // also implies the memo table is enabled.
+      opts.d_progMemo = true;
+      opts.d_progMemoSize = std::stoul(size);
+      continue;
+    }
+    if (arg == "--gen-compile" || arg.compare(0, 16, "--load-compiled=") == 0)
+    {
+#ifdef EO_COMPILED_SIGNATURES
+      if (plugin != nullptr)
+      {
+        EO_FATAL() << "Error: cannot use both --gen-compile and --load-compiled";
+      }
+      if (arg == "--gen-compile")
+      {
+        plugin = new Compiler(s);
+      }
+      else
+      {
+        plugin = Executor::load(s, arg.substr(16));
+      }
+      continue;
+#else
+      EO_FATAL() << "Error: compiled signatures not supported in this build";
+#endif /* EO_COMPILED_SIGNATURES */
+    }
     if (arg == "--help")
     {
       std::stringstream out;
       out << "     --binder-fresh: binders generate fresh variables when parsed in proof files." << std::endl;
+      out << "          --eval-vm: evaluate programs and the types of proof rules using a bytecode interpreter." << std::endl;
+      out << "      --gen-compile: generate C++ code for the signatures included by the input in compiled.out.cpp." << std::endl;
       out << "        --include=X: includes the file specified by X." << std::endl;
       out << "             --help: displays this message." << std::endl;
+      out << "       --inst-cache: cache the conclusions of proof rules by their rule and the context they are instantiated in." << std::endl;
+      out << "  --load-compiled=X: use the compiled signature in the shared object X, built from the output of --gen-compile." << std::endl;
+      out << "       --nary-apply: store applications of curried functions as single n-ary application terms." << std::endl;
       out << "    --normalize-num: treat numeral literals as syntax sugar for rational literals." << std::endl;
       out << " --no-normalize-dec: do not treat decimal literals as syntax sugar for rational literals." << std::endl;
       out << " --no-normalize-hex: do not treat hexadecimal literals as syntax sugar for binary literals." << std::endl;
       out << "     --no-parse-let: do not treat let as a builtin symbol for specifying terms having shared subterms." << std::endl;
       out << "     --no-print-let: do not letify the output of terms in error messages and trace messages." << std::endl;
       out << "--no-rule-sym-table: do not use a separate symbol table for proof rules and declared terms." << std::endl;
+      out << "   --pipeline-parse: lex input files on a separate thread, ahead of the commands being checked." << std::endl;
+      out << "        --prog-memo: memoize the results of programs applied to ground arguments across proof steps." << std::endl;
+      out << " --prog-memo-size=N: use at most N entries in the memo table for programs (default 65536)." << std::endl;
       out << "      --reference=X: includes the file specified by X as a reference file." << std::endl;
       out << "      --show-config: displays the build information for this binary." << std::endl;
       out << "            --stats: enables detailed statistics." << std::endl;
+      out << "      --stats-alloc: print the memory occupancy of the expression allocator in the statistics." << std::endl;
       out << "    --stats-compact: print statistics in a compact format." << std::endl;
+      out << "      --stdin-piped: read the input on stdin in blocks on a separate thread (default if stdin is not a terminal)." << std::endl;
       out << "           -t <tag>: enables the given trace tag (requires debug build)." << std::endl;
       out << "                 -v: verbose mode, enable all standard trace messages (requires debug build)." << std::endl;
       std::cout << out.str();
@@ -92,6 +139,13 @@ int main( int argc, char* argv[] )
       out << "yes";
 #else
       out << "no";
+#endif
+      out << std::endl;
+      out << std::setw(w) << "compiled : ";
+#ifdef EO_COMPILED_SIGNATURES
+      out << "yes";
+#else
+      out << "no";
 #endif
       out << std::endl;
       std::cout << out.str();
@@ -158,7 +212,17 @@ int main( int argc, char* argv[] )
     // parse from std::cin.
     // we assume this is a proof (not signature, not reference)
     Parser p(s, false, false);
-    p.setStreamInput(std::cin);
+    // if stdin is not a terminal, e.g. a pipe, a file or a socket, we read
+    // it in blocks, otherwise we read it character by character
+    int fd = fileno(stdin);
+    if (opts.d_stdinPiped || !isatty(fd))
+    {
+      p.setPipedInput(fd);
+    }
+    else
+    {
+      p.setStreamInput(std::cin);
+    }
     // parse commands until finished
     while (p.parseNextCommand())
     {
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "pair_marker.h"
+
+#include <functional>
+
+namespace ethos {
+
+PairMarker::PairMarker() : d_table(64), d_epoch(1), d_count(0) {}
+
+PairMarker::~PairMarker() {}
+
+void PairMarker::clear()
+{
+  d_count = 0;
+  d_epoch++;
+  if (d_epoch == 0)
+  {
+    // the epoch wrapped around, reset the stamps of all entries
+    d_table.assign(d_table.size(), Entry());
+    d_epoch = 1;
+  }
+}
+
+size_t PairMarker::getSlot(const ExprValue* a, const ExprValue* b) const
+{
+  size_t h = std::hash<const ExprValue*>()(a) * 0x9e3779b97f4a7c15ULL
+             ^ std::hash<const ExprValue*>()(b);
+  h ^= (h >> 29);
+  return h & (d_table.size() - 1);
+}
+
+bool PairMarker::mark(const ExprValue* a, const ExprValue* b)
+{
+  // keep the load factor at most one half
+  if (2 * (d_count + 1) > d_table.size())
+  {
+    grow();
+  }
+  size_t mask = d_table.size() - 1;
+  for (size_t i = getSlot(a, b);; i = (i + 1) & mask)
+  {
+    Entry& e = d_table[i];
+    if (e.d_epoch != d_epoch)
+    {
+      e.d_a = a;
+      e.d_b = b;
+      e.d_epoch = d_epoch;
+      d_count++;
+      return true;
+    }
+    if (e.d_a == a && e.d_b == b)
+    {
+      return false;
+    }
+  }
+}
+
+void PairMarker::grow()
+{
+  std::vector<Entry> old(2 * d_table.size());
+  old.swap(d_table);
+  size_t mask = d_table.size() - 1;
+  for (const Entry& e : old)
+  {
+    if (e.d_epoch != d_epoch)
+    {
+      continue;
+    }
+    size_t i = getSlot(e.d_a, e.d_b);
+    while (d_table[i].d_epoch == d_epoch)
+    {
+      i = (i + 1) & mask;
+    }
+    d_table[i] = e;
+  }
+}
+
+}  // namespace ethos
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef PAIR_MARKER_H
+#define PAIR_MARKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ethos {
+
+class ExprValue;
+
+/**
+ * A set of pairs of expressions that is cleared in constant time.
+ *
+ * Pairs are stored in an open addressing table whose entries are stamped with
+ * the epoch in which they were added. Clearing the set starts a new epoch,
+ * after which all existing entries are considered empty. The table is only
+ * reallocated when it grows, hence marking is allocation-free once the table
+ * is large enough.
+ */
+class PairMarker
+{
+ public:
+  PairMarker();
+  ~PairMarker();
+  /** Remove all pairs */
+  void clear();
+  /** Add the pair (a, b), return false if it was already added */
+  bool mark(const ExprValue* a, const ExprValue* b);
+
+ private:
+  /** An entry of the table, which is empty if its epoch is not current */
+  class Entry
+  {
+   public:
+    Entry() : d_a(nullptr), d_b(nullptr), d_epoch(0) {}
+    const ExprValue* d_a;
+    const ExprValue* d_b;
+    uint32_t d_epoch;
+  };
+  /** Get the initial slot for (a, b) */
+  size_t getSlot(const ExprValue* a, const ExprValue* b) const;
+  /** Double the size of the table, keeping the entries of the current epoch */
+  void grow();
+  /** The table, whose size is a power of two */
+  std::vector<Entry> d_table;
+  /** The current epoch, which is never zero */
+  uint32_t d_epoch;
+  /** The number of pairs added in the current epoch */
+  size_t d_count;
+};
+
+}  // namespace ethos
+
+#endif /* PAIR_MARKER_H */
@@ -21,7 +21,8 @@ Parser::Parser(State& s, bool isSignature, bool isReference)
 void Parser::setFileInput(const std::string& filename)
 {
   d_input = Input::mkFileInput(filename);
-  d_lex.initialize(d_input.get(), filename);
+  d_lex.initialize(
+      d_input.get(), filename, d_state.getOptions().d_pipelineParse);
 }
 
 void Parser::setStreamInput(std::istream& input)
@@ -30,6 +31,12 @@ void Parser::setStreamInput(std::istream& input)
   d_lex.initialize(d_input.get(), "stream");
 }
 
+void Parser::setPipedInput(int fd)
+{
+  d_input = Input::mkPipedInput(fd);
+  d_lex.initialize(d_input.get(), "stream");
+}
+
 void Parser::setStringInput(const std::string& input)
 {
   d_input = Input::mkStringInput(input);
@@ -43,6 +43,11 @@ class Parser
    * @param input the input stream
    */
   void setStreamInput(std::istream& input);
+  /** Set the input for the given file descriptor, which is read in blocks.
+   *
+   * @param fd the file descriptor
+   */
+  void setPipedInput(int fd);
   /** Set the string input for the given file.
    *
    * @param filename the input
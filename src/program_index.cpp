@@ -0,0 +1,171 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "program_index.h"
+
+#include "base/check.h"
+
+namespace ethos {
+
+ProgramIndex::ProgramIndex(const Expr& prog) : d_prog(prog), d_arity(0)
+{
+  size_t ncases = prog.getNumChildren();
+  Assert(ncases > 0);
+  d_nwords = (ncases + 63) / 64;
+  d_arity = prog[0][0].getNumChildren();
+  d_positions.resize(d_arity);
+  d_all = allocMask();
+  for (size_t i = 0; i < ncases; i++)
+  {
+    addCase(d_all, i);
+  }
+  for (size_t j = 1; j < d_arity; j++)
+  {
+    Position& p = d_positions[j];
+    p.d_wild = allocMask();
+    for (size_t i = 0; i < ncases; i++)
+    {
+      const ExprValue* hd = prog[i][0].getValue();
+      // cases of the wrong arity are caught when the program is called
+      if (hd->getNumChildren() != d_arity)
+      {
+        addCase(p.d_wild, i);
+        continue;
+      }
+      const ExprValue* pat = (*hd)[j];
+      size_t offset;
+      if (pat->getNumChildren() == 0)
+      {
+        if (pat->getKind() == Kind::PARAM)
+        {
+          addCase(p.d_wild, i);
+          continue;
+        }
+        offset = getOffset(p.d_atoms, pat);
+      }
+      else if (pat->getKind() == Kind::APPLY)
+      {
+        const ExprValue* phd = getHead(pat);
+        if (phd->getKind() == Kind::PARAM)
+        {
+          offset = getOffset(p.d_kinds, Kind::APPLY);
+        }
+        else
+        {
+          offset = getOffset(p.d_heads, phd);
+        }
+      }
+      else
+      {
+        offset = getOffset(p.d_kinds, pat->getKind());
+      }
+      addCase(offset, i);
+      p.d_trivial = false;
+    }
+  }
+}
+
+ProgramIndex::~ProgramIndex() {}
+
+const ExprValue* ProgramIndex::getHead(const ExprValue* e)
+{
+  while (e->getKind() == Kind::APPLY)
+  {
+    e = (*e)[0];
+  }
+  return e;
+}
+
+template <typename K>
+size_t ProgramIndex::getOffset(std::unordered_map<K, size_t>& m, const K& key)
+{
+  typename std::unordered_map<K, size_t>::iterator it = m.find(key);
+  if (it != m.end())
+  {
+    return it->second;
+  }
+  size_t offset = allocMask();
+  m[key] = offset;
+  return offset;
+}
+
+size_t ProgramIndex::allocMask()
+{
+  size_t offset = d_masks.size();
+  d_masks.resize(offset + d_nwords, 0);
+  return offset;
+}
+
+void ProgramIndex::addCase(size_t offset, size_t i)
+{
+  d_masks[offset + i / 64] |= (static_cast<uint64_t>(1) << (i % 64));
+}
+
+bool ProgramIndex::getCandidates(const std::vector<ExprValue*>& args,
+                                 std::vector<uint64_t>& mask) const
+{
+  Assert(args.size() == d_arity);
+  mask.assign(d_masks.begin() + d_all, d_masks.begin() + d_all + d_nwords);
+  // the bitsets whose union is the candidates for the current position
+  const uint64_t* classes[4];
+  for (size_t j = 1; j < d_arity; j++)
+  {
+    const Position& p = d_positions[j];
+    if (p.d_trivial)
+    {
+      continue;
+    }
+    const ExprValue* a = args[j];
+    size_t nclasses = 0;
+    classes[nclasses++] = &d_masks[p.d_wild];
+    std::unordered_map<const ExprValue*, size_t>::const_iterator it;
+    if (a->getNumChildren() == 0)
+    {
+      it = p.d_atoms.find(a);
+      if (it != p.d_atoms.end())
+      {
+        classes[nclasses++] = &d_masks[it->second];
+      }
+    }
+    else if (a->getKind() == Kind::APPLY && !p.d_heads.empty())
+    {
+      it = p.d_heads.find(getHead(a));
+      if (it != p.d_heads.end())
+      {
+        classes[nclasses++] = &d_masks[it->second];
+      }
+    }
+    if (!p.d_kinds.empty())
+    {
+      std::unordered_map<Kind, size_t>::const_iterator itk =
+          p.d_kinds.find(a->getKind());
+      if (itk != p.d_kinds.end())
+      {
+        classes[nclasses++] = &d_masks[itk->second];
+      }
+    }
+    bool nonEmpty = false;
+    for (size_t w = 0; w < d_nwords; w++)
+    {
+      uint64_t u = 0;
+      for (size_t k = 0; k < nclasses; k++)
+      {
+        u |= classes[k][w];
+      }
+      mask[w] &= u;
+      nonEmpty = nonEmpty || mask[w] != 0;
+    }
+    if (!nonEmpty)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace ethos
@@ -0,0 +1,105 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef PROGRAM_INDEX_H
+#define PROGRAM_INDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "expr.h"
+#include "kind.h"
+
+namespace ethos {
+
+/**
+ * A discrimination index over the cases of a program, which is computed once
+ * when the program is defined.
+ *
+ * For each argument position, each case is classified by the top of its
+ * pattern at that position:
+ * - a parameter, which matches any argument,
+ * - an atomic term, which matches only that term,
+ * - an application whose head (the first non-application in the chain of
+ * operators) is not a parameter, which matches only applications with that
+ * head,
+ * - any other term, which matches only terms of the same kind.
+ * The set of cases in each class is stored as a bitset. Given the arguments of
+ * a call, the candidate cases are obtained by intersecting, over all
+ * positions, the union of the classes the argument falls into. This is an
+ * over-approximation of the cases that match, since e.g. non-linear patterns
+ * and the arguments of applications are not considered; hence the candidates
+ * are still matched in order against the arguments.
+ */
+class ProgramIndex
+{
+ public:
+  ProgramIndex(const Expr& prog);
+  ~ProgramIndex();
+  /** Get the program, whose children are the cases */
+  const Expr& getProgram() const { return d_prog; }
+  /**
+   * Get the number of children of the head of each case, which includes the
+   * program itself.
+   */
+  size_t getArity() const { return d_arity; }
+  /** Get the number of words in a bitset of cases */
+  size_t getNumWords() const { return d_nwords; }
+  /**
+   * Compute the bitset of candidate cases for the application given by args,
+   * where args[0] is the program and args.size() is equal to getArity().
+   * The result is stored in mask, which is resized to getNumWords(). Returns
+   * false if there are no candidates.
+   */
+  bool getCandidates(const std::vector<ExprValue*>& args,
+                     std::vector<uint64_t>& mask) const;
+
+ private:
+  /** The index for an argument position */
+  class Position
+  {
+   public:
+    Position() : d_wild(0), d_trivial(true) {}
+    /** Offset of the bitset of cases whose pattern is a parameter */
+    size_t d_wild;
+    /** Whether all patterns at this position are parameters */
+    bool d_trivial;
+    /** Offsets of the bitsets of cases whose pattern is the atomic term */
+    std::unordered_map<const ExprValue*, size_t> d_atoms;
+    /** Offsets of the bitsets of cases whose pattern has the given head */
+    std::unordered_map<const ExprValue*, size_t> d_heads;
+    /** Offsets of the bitsets of cases whose pattern has the given kind */
+    std::unordered_map<Kind, size_t> d_kinds;
+  };
+  /** Get the head of the chain of applications e */
+  static const ExprValue* getHead(const ExprValue* e);
+  /** Get the offset of the bitset for key in m, allocating it if necessary */
+  template <typename K>
+  size_t getOffset(std::unordered_map<K, size_t>& m, const K& key);
+  /** Allocate a new empty bitset, return its offset */
+  size_t allocMask();
+  /** Add case i to the bitset at the given offset */
+  void addCase(size_t offset, size_t i);
+  /** The program */
+  Expr d_prog;
+  /** The arity of the cases */
+  size_t d_arity;
+  /** The number of words per bitset */
+  size_t d_nwords;
+  /** The bitset of all cases */
+  size_t d_all;
+  /** The storage for all bitsets */
+  std::vector<uint64_t> d_masks;
+  /** The index of each argument position (the program is position 0) */
+  std::vector<Position> d_positions;
+};
+
+}  // namespace ethos
+
+#endif /* PROGRAM_INDEX_H */
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "program_memo.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/check.h"
+
+namespace ethos {
+
+ProgramMemo::ProgramMemo() : d_clock(0) {}
+
+ProgramMemo::~ProgramMemo() {}
+
+bool ProgramMemo::find(const ExprValue* app, Expr& result)
+{
+  std::unordered_map<const ExprValue*, Entry>::iterator it =
+      d_entries.find(app);
+  if (it == d_entries.end())
+  {
+    return false;
+  }
+  it->second.d_lastUse = ++d_clock;
+  result = it->second.d_result;
+  return true;
+}
+
+size_t ProgramMemo::insert(const Expr& app, const Expr& result, size_t budget)
+{
+  d_entries.emplace(app.getValue(), Entry(app, result, ++d_clock));
+  if (d_entries.size() <= budget)
+  {
+    return 0;
+  }
+  return evict(budget - budget / 4);
+}
+
+void ProgramMemo::erase(const ExprValue* prog)
+{
+  std::unordered_map<const ExprValue*, Entry>::iterator it;
+  for (it = d_entries.begin(); it != d_entries.end();)
+  {
+    if ((*it->first)[0] == prog)
+    {
+      it = d_entries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void ProgramMemo::clear() { d_entries.clear(); }
+
+bool ProgramMemo::isDead(const ExprValue* app)
+{
+  // an argument with a single reference is only referenced by app, which is
+  // itself only referenced by the table
+  for (size_t i = 1, nchildren = app->getNumChildren(); i < nchildren; i++)
+  {
+    if ((*app)[i]->d_rc <= 1)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t ProgramMemo::evict(size_t target)
+{
+  size_t nprev = d_entries.size();
+  std::unordered_map<const ExprValue*, Entry>::iterator it;
+  for (it = d_entries.begin(); it != d_entries.end();)
+  {
+    if (isDead(it->first))
+    {
+      it = d_entries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  if (d_entries.size() > target)
+  {
+    // evict the least recently used entries
+    std::vector<uint64_t> uses;
+    uses.reserve(d_entries.size());
+    for (const std::pair<const ExprValue* const, Entry>& e : d_entries)
+    {
+      uses.push_back(e.second.d_lastUse);
+    }
+    size_t nevict = d_entries.size() - target;
+    std::nth_element(uses.begin(), uses.begin() + (nevict - 1), uses.end());
+    uint64_t cutoff = uses[nevict - 1];
+    for (it = d_entries.begin(); it != d_entries.end();)
+    {
+      if (it->second.d_lastUse <= cutoff)
+      {
+        it = d_entries.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+  Assert(d_entries.size() <= target);
+  return nprev - d_entries.size();
+}
+
+}  // namespace ethos
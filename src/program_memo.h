@@ -0,0 +1,81 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef PROGRAM_MEMO_H
+#define PROGRAM_MEMO_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "expr.h"
+
+namespace ethos {
+
+/**
+ * A memo table for the results of applications of programs to ground
+ * arguments, which persists across calls to TypeChecker::evaluate.
+ *
+ * Applications are keyed by their (hash-consed) application term, hence the
+ * memo table holds a reference to each application, its arguments and its
+ * result. When the number of entries exceeds a budget, entries are evicted
+ * until the table is at three quarters of the budget. Entries that have an
+ * argument that is no longer referenced outside of the table are evicted
+ * first, since the same call can then only recur if that argument is rebuilt.
+ * The remaining entries are evicted least recently used first.
+ */
+class ProgramMemo
+{
+ public:
+  ProgramMemo();
+  ~ProgramMemo();
+  /**
+   * Get the result of the application app, which is null if app does not
+   * evaluate. Returns false if app is not in the table.
+   */
+  bool find(const ExprValue* app, Expr& result);
+  /**
+   * Set the result of the application app, evicting entries if the number of
+   * entries exceeds budget. Returns the number of evicted entries.
+   */
+  size_t insert(const Expr& app, const Expr& result, size_t budget);
+  /** Get the number of entries */
+  size_t size() const { return d_entries.size(); }
+  /** Remove the entries for applications of the program prog */
+  void erase(const ExprValue* prog);
+  /** Remove all entries */
+  void clear();
+
+ private:
+  /** An entry of the table */
+  class Entry
+  {
+   public:
+    Entry(const Expr& app, const Expr& result, uint64_t lastUse)
+        : d_app(app), d_result(result), d_lastUse(lastUse)
+    {
+    }
+    /** The application, which the table holds a reference to */
+    Expr d_app;
+    /** Its result */
+    Expr d_result;
+    /** The last time this entry was used */
+    uint64_t d_lastUse;
+  };
+  /** Is the entry for app only relevant to terms held by this table? */
+  static bool isDead(const ExprValue* app);
+  /** Evict entries until at most target remain, return the number evicted */
+  size_t evict(size_t target);
+  /** The clock, incremented on each use of an entry */
+  uint64_t d_clock;
+  /** The entries */
+  std::unordered_map<const ExprValue*, Entry> d_entries;
+};
+
+}  // namespace ethos
+
+#endif /* PROGRAM_MEMO_H */
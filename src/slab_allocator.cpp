@@ -0,0 +1,135 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "slab_allocator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#include "base/check.h"
+
+namespace ethos {
+
+SlabAllocator::SizeClass::SizeClass()
+    : d_objSize(0),
+      d_objsPerSlab(0),
+      d_next(nullptr),
+      d_end(nullptr),
+      d_free(nullptr),
+      d_numLive(0)
+{
+}
+
+SlabAllocator::SlabAllocator() {}
+
+SlabAllocator::~SlabAllocator()
+{
+  for (SizeClass& sc : d_classes)
+  {
+    for (char* s : sc.d_slabs)
+    {
+      ::operator delete(s);
+    }
+  }
+}
+
+SlabAllocator::SizeClass& SlabAllocator::getSizeClass(size_t size)
+{
+  Assert(size > 0);
+  size_t index = (size - 1) / s_granularity;
+  if (index >= d_classes.size())
+  {
+    size_t prevSize = d_classes.size();
+    d_classes.resize(index + 1);
+    for (size_t i = prevSize; i <= index; i++)
+    {
+      SizeClass& sc = d_classes[i];
+      sc.d_objSize = (i + 1) * s_granularity;
+      sc.d_objsPerSlab = std::max(s_slabBytes / sc.d_objSize, size_t(1));
+    }
+  }
+  return d_classes[index];
+}
+
+void* SlabAllocator::allocate(size_t size)
+{
+  SizeClass& sc = getSizeClass(size);
+  sc.d_numLive++;
+  // recycle a free object if one exists
+  if (sc.d_free != nullptr)
+  {
+    FreeObject* ret = sc.d_free;
+    sc.d_free = ret->d_next;
+    return ret;
+  }
+  if (sc.d_next == sc.d_end)
+  {
+    // allocate a new slab
+    size_t nbytes = sc.d_objSize * sc.d_objsPerSlab;
+    char* s = static_cast<char*>(::operator new(nbytes));
+    sc.d_slabs.push_back(s);
+    sc.d_next = s;
+    sc.d_end = s + nbytes;
+  }
+  void* ret = sc.d_next;
+  sc.d_next += sc.d_objSize;
+  return ret;
+}
+
+void SlabAllocator::deallocate(void* p, size_t size)
+{
+  Assert(p != nullptr);
+  SizeClass& sc = getSizeClass(size);
+  Assert(sc.d_numLive > 0);
+  sc.d_numLive--;
+  FreeObject* fo = static_cast<FreeObject*>(p);
+  fo->d_next = sc.d_free;
+  sc.d_free = fo;
+}
+
+std::string SlabAllocator::toString() const
+{
+  std::stringstream ss;
+  size_t totalSlabs = 0;
+  size_t totalBytes = 0;
+  size_t liveObjects = 0;
+  size_t liveBytes = 0;
+  for (const SizeClass& sc : d_classes)
+  {
+    if (sc.d_slabs.empty())
+    {
+      continue;
+    }
+    size_t capacity = sc.d_slabs.size() * sc.d_objsPerSlab;
+    double pct = static_cast<double>(100 * sc.d_numLive)
+                 / static_cast<double>(capacity);
+    std::stringstream sp;
+    sp << std::fixed << std::setprecision(1) << pct;
+    ss << "slabOccupancy[" << sc.d_objSize << "] = " << sc.d_numLive << " / "
+       << capacity << " (" << sp.str() << "%) in " << sc.d_slabs.size()
+       << " slabs" << std::endl;
+    totalSlabs += sc.d_slabs.size();
+    totalBytes += capacity * sc.d_objSize;
+    liveObjects += sc.d_numLive;
+    liveBytes += sc.d_numLive * sc.d_objSize;
+  }
+  ss << "slabCount = " << totalSlabs << std::endl;
+  ss << "slabBytes = " << totalBytes << std::endl;
+  double avgBytes = liveObjects == 0 ? 0.0
+                                     : static_cast<double>(liveBytes)
+                                           / static_cast<double>(liveObjects);
+  std::stringstream sa;
+  sa << std::fixed << std::setprecision(1) << avgBytes;
+  ss << "slabLiveBytes = " << liveBytes << " (avg " << sa.str()
+     << " per expression)" << std::endl;
+  return ss.str();
+}
+
+}  // namespace ethos
@@ -0,0 +1,77 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ethos {
+
+/**
+ * A size-class slab allocator, used for allocating expression nodes.
+ *
+ * Requests are rounded up to a multiple of 8 bytes and served from the
+ * size class for that size. Each size class allocates fixed size slabs and
+ * carves objects from the most recent slab. Deallocated objects are pushed
+ * to a free list for their size class and recycled by later allocations.
+ * Memory is only returned to the system when the allocator is destroyed.
+ */
+class SlabAllocator
+{
+ public:
+  SlabAllocator();
+  ~SlabAllocator();
+  /** Allocate uninitialized memory for an object of the given size. */
+  void* allocate(size_t size);
+  /** Deallocate p, which was allocated by a call to allocate(size). */
+  void deallocate(void* p, size_t size);
+  /** Get a summary of the occupancy of each size class. */
+  std::string toString() const;
+
+ private:
+  /** The granularity of size classes, in bytes */
+  static const size_t s_granularity = 8;
+  /** The target number of bytes per slab */
+  static const size_t s_slabBytes = 64 * 1024;
+  /** A free object, which stores the next free object of its size class */
+  struct FreeObject
+  {
+    FreeObject* d_next;
+  };
+  /** All objects of a given size */
+  class SizeClass
+  {
+   public:
+    SizeClass();
+    /** The size of objects, in bytes */
+    size_t d_objSize;
+    /** The number of objects per slab */
+    size_t d_objsPerSlab;
+    /** The slabs allocated for this size class */
+    std::vector<char*> d_slabs;
+    /** The next unused object in the last slab */
+    char* d_next;
+    /** The end of the last slab */
+    char* d_end;
+    /** The free list */
+    FreeObject* d_free;
+    /** The number of objects currently allocated */
+    size_t d_numLive;
+  };
+  /** Get the size class for objects of the given size */
+  SizeClass& getSizeClass(size_t size);
+  /** The size classes, where the i^th stores objects of size 8*(i+1) */
+  std::vector<SizeClass> d_classes;
+};
+
+}  // namespace ethos
+
+#endif /* SLAB_ALLOCATOR_H */
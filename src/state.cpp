@@ -23,11 +23,19 @@ Options::Options()
   d_printLet = false;
   d_stats = false;
   d_statsCompact = false;
+  d_statsAlloc = false;
   d_ruleSymTable = true;
   d_normalizeDecimal = true;
   d_normalizeHexadecimal = true;
   d_normalizeNumeral = false;
   d_binderFresh = false;
+  d_naryApply = false;
+  d_instCache = false;
+  d_progMemo = false;
+  d_progMemoSize = 1 << 16;
+  d_evalVm = false;
+  d_stdinPiped = false;
+  d_pipelineParse = false;
 }
 
 bool Options::setOption(const std::string& key, bool val)
@@ -57,6 +65,15 @@ bool Options::setOption(const std::string& key, bool val)
     }
     d_statsCompact = val;
   }
+  else if (key == "stats-alloc")
+  {
+    if (val)
+    {
+      // also implies stats are enabled.
+      d_stats = val;
+    }
+    d_statsAlloc = val;
+  }
   else if (key == "rule-sym-table")
   {
     d_ruleSymTable = val;
@@ -73,6 +90,30 @@ bool Options::setOption(const std::string& key, bool val)
   {
     d_normalizeHexadecimal = val;
   }
+  else if (key == "nary-apply")
+  {
+    d_naryApply = val;
+  }
+  else if (key == "inst-cache")
+  {
+    d_instCache = val;
+  }
+  else if (key == "prog-memo")
+  {
+    d_progMemo = val;
+  }
+  else if (key == "eval-vm")
+  {
+    d_evalVm = val;
+  }
+  else if (key == "stdin-piped")
+  {
+    d_stdinPiped = val;
+  }
+  else if (key == "pipeline-parse")
+  {
+    d_pipelineParse = val;
+  }
   else
   {
     return false;
@@ -84,6 +125,7 @@ bool Options::setOption(const std::string& key, bool val)
 
 State::State(Options& opts, Stats& stats)
     : d_hashCounter(0),
+      d_exprTable(stats),
       d_hasReference(false),
       d_inGarbageCollection(false),
       d_tc(*this, opts),
@@ -157,9 +199,9 @@ State::State(Options& opts, Stats& stats)
   // common constants
   d_type = Expr(mkExprInternal(Kind::TYPE, {}));
   d_boolType = Expr(mkExprInternal(Kind::BOOL_TYPE, {}));
-  d_true = Expr(new Literal(true));
+  d_true = Expr(mkNode<Literal>(true));
   bind("true", d_true);
-  d_false = Expr(new Literal(false));
+  d_false = Expr(mkNode<Literal>(false));
   bind("false", d_false);
 
   // builtin lists
@@ -233,21 +275,21 @@ void State::popScope()
     if (!d_overloadedDecls.empty() && d_overloadedDecls.back()==d_decls[i])
     {
       d_overloadedDecls.pop_back();
-      std::map<std::string, Expr>::iterator its = d_symTable.find(d_decls[i]);
-      Assert (its!=d_symTable.end());
+      Expr& entry = d_symTable[d_decls[i]];
+      Assert (!entry.isNull());
       // it should be overloaded
-      AppInfo* ai = getAppInfo(its->second.getValue());
+      AppInfo* ai = getAppInfo(entry.getValue());
       Assert (ai!=nullptr);
       // we always have at least 2 overloads
       Assert (ai->d_overloads.size()>=2);
       // was overloaded, we revert the binding
       ai->d_overloads.pop_back();
       Expr tmp = ai->d_overloads.back();
-      its->second = tmp;
+      entry = tmp;
       continue;
     }
-    Trace("overload") << "** unbind " << d_decls[i] << std::endl;
-    d_symTable.erase(d_decls[i]);
+    Trace("overload") << "** unbind " << d_symbols.getName(d_decls[i]) << std::endl;
+    d_symTable[d_decls[i]] = d_null;
   }
   d_decls.resize(lastSize);
 }
@@ -293,7 +335,11 @@ bool State::includeFile(const std::string& s, bool isSignature, bool isReference
     return false;
   }
 
-  if (!markIncluded(inputPath))
+  // files are identified by their real path, so that a file is included once
+  // no matter how it is referred to, and so that the paths recorded by plugins
+  // do not depend on the working directory
+  Filepath realPath = inputPath.getRealPath();
+  if (!markIncluded(realPath))
   {
     return true;
   }
@@ -305,7 +351,7 @@ bool State::includeFile(const std::string& s, bool isSignature, bool isReference
   if (d_plugin!=nullptr)
   {
     Assert (!isReference);
-    d_plugin->includeFile(inputPath, isReference, referenceNf);
+    d_plugin->includeFile(realPath, isReference, referenceNf);
   }
   Trace("state") << "Include " << inputPath << std::endl;
   Assert (getAssumptionLevel()==0);
@@ -325,7 +371,7 @@ bool State::includeFile(const std::string& s, bool isSignature, bool isReference
     EO_FATAL() << "Including file " << inputPath.getRawPath()
                << " did not preserve assumption scope. The most recent open "
                   "assumption was "
-               << d_decls[d_declsSizeCtx.back()] << ".";
+               << d_symbols.getName(d_decls[d_declsSizeCtx.back()]) << ".";
   }
   return true;
 }
@@ -359,7 +405,15 @@ void State::markDeleted(ExprValue* e)
     {
       case Kind::NUMERAL:
       {
-        std::unordered_map<Integer, Expr, IntegerHashFunction>::iterator it = d_litIntMap.find(e->asLiteral()->d_int);
+        const Integer& ei = e->asLiteral()->d_int;
+        if (ei.isSmall())
+        {
+          std::unordered_map<int64_t, Expr>::iterator it = d_litSmallIntMap.find(ei.getSmall());
+          Assert (it!=d_litSmallIntMap.end());
+          d_litSmallIntMap.erase(it);
+          break;
+        }
+        std::unordered_map<Integer, Expr, IntegerHashFunction>::iterator it = d_litIntMap.find(ei);
         Assert (it!=d_litIntMap.end());
         d_litIntMap.erase(it);
       }
@@ -393,34 +447,45 @@ void State::markDeleted(ExprValue* e)
         break;
       default:
       {
-        if (isSymbol(k))
+        if (!isSymbol(k))
         {
-          std::map<const ExprValue*, AppInfo>::const_iterator it = d_appData.find(e);
-          if (it != d_appData.end())
-          {
-            d_appData.erase(it);
-          }
+          // remove from the expression table
+          d_exprTable.remove(e);
         }
       }
       break;
     }
-    std::map<const ExprValue*, size_t>::const_iterator ith = d_hashMap.find(e);
-    if (ith != d_hashMap.end())
+    if (e->getFlag(ExprValue::Flag::HAS_APP_INFO))
+    {
+      d_appData.erase(e);
+    }
+    if (e->getFlag(ExprValue::Flag::HAS_HASH))
+    {
+      d_hashMap.erase(e);
+    }
+    if (e->getFlag(ExprValue::Flag::HAS_LIST_CACHE))
+    {
+      d_listCache.erase(e);
+    }
+    if (e->d_type != nullptr)
+    {
+      // release the reference to the type
+      e->d_type->dec();
+    }
+    // Now, free the expression and return its memory to the allocator. Note
+    // that we do not garbage collect its children here.
+    if (e->asLiteral()!=nullptr)
     {
-      d_hashMap.erase(ith);
+      Literal* l = static_cast<Literal*>(e);
+      l->~Literal();
+      d_alloc.deallocate(l, sizeof(Literal));
     }
-    std::map<const ExprValue*, Expr>::const_iterator itt = d_typeCache.find(e);
-    if (itt != d_typeCache.end())
+    else
     {
-      d_typeCache.erase(itt);
+      size_t size = ExprValue::getAllocSize(e->getNumChildren());
+      e->~ExprValue();
+      d_alloc.deallocate(e, size);
     }
-    // remove from the expression trie
-    ExprTrie* et = &d_trie[e->getKind()];
-    Assert(et != nullptr);
-    const std::vector<ExprValue*>& children = e->d_children;
-    et->remove(children);
-    // now, free the expression
-    free(e);
     if (!d_toDelete.empty())
     {
       e = d_toDelete.back();
@@ -616,9 +681,9 @@ ExprValue* State::mkSymbolInternal(Kind k,
   d_stats.d_symCount++;
   d_stats.d_exprCount++;
   std::vector<ExprValue*> emptyVec;
-  ExprValue* v = new Literal(k, name);
+  ExprValue* v = mkNode<Literal>(k, name);
   // immediately set its type
-  d_typeCache[v] = type;
+  setType(v, type.getValue());
   Trace("type_checker") << "TYPE " << name << " : " << type << std::endl;
   //d_symcMap[key] = v;
   return v;
@@ -839,7 +904,7 @@ Expr State::mkExpr(Kind k, const std::vector<Expr>& children)
     if (hk==Kind::LAMBDA)
     {
       // beta-reduce eagerly, if the correct arity
-      const std::vector<ExprValue*>& vars = (*hd)[0]->getChildren();
+      ExprSpan vars = (*hd)[0]->getChildren();
       size_t nvars = vars.size();
       if (nvars==children.size()-1)
       {
@@ -869,13 +934,29 @@ Expr State::mkExpr(Kind k, const std::vector<Expr>& children)
         // only do this if the correct arity
         if (t.getNumChildren() == children.size())
         {
-          Ctx ctx;
-          Expr e = d_tc.evaluateProgramInternal(vchildren, ctx);
-          if (!e.isNull())
+          Expr app, ret;
+          if (d_tc.findProgramMemo(vchildren, ret, app))
+          {
+            if (!ret.isNull())
+            {
+              Trace("state") << "EAGER_EVALUATE (memoized) " << ret << std::endl;
+              return ret;
+            }
+          }
+          else
           {
-            Expr ret = d_tc.evaluate(e.getValue(), ctx);
-            Trace("state") << "EAGER_EVALUATE " << ret << std::endl;
-            return ret;
+            Ctx ctx;
+            Expr e = d_tc.evaluateProgramInternal(vchildren, ctx);
+            if (!e.isNull())
+            {
+              ret = d_tc.evaluate(e.getValue(), ctx);
+            }
+            d_tc.insertProgramMemo(app, ret);
+            if (!ret.isNull())
+            {
+              Trace("state") << "EAGER_EVALUATE " << ret << std::endl;
+              return ret;
+            }
           }
         }
         else
@@ -890,7 +971,7 @@ Expr State::mkExpr(Kind k, const std::vector<Expr>& children)
     // The exceptions to this are operators whose types are not flattened (programs and proof rules).
     if (children.size()>2)
     {
-      if (hk!=Kind::PROGRAM_CONST && hk!=Kind::PROOF_RULE && hk!=Kind::ORACLE)
+      if (!isNonCurriedSymbol(hk))
       {
         // return the curried version
         return Expr(mkApplyInternal(vchildren));
@@ -1011,12 +1092,24 @@ ExprValue* State::mkLiteralInternal(Literal& l)
       return l.d_bool ? d_true.getValue() : d_false.getValue();
     case Kind::NUMERAL:
     {
+      if (l.d_int.isSmall())
+      {
+        // numerals that fit into 64 bits are looked up by their value
+        Expr& ret = d_litSmallIntMap[l.d_int.getSmall()];
+        if (!ret.isNull())
+        {
+          return ret.getValue();
+        }
+        ev = mkNode<Literal>(l.d_int);
+        ret = Expr(ev);
+        break;
+      }
       std::unordered_map<Integer, Expr, IntegerHashFunction>::iterator it = d_litIntMap.find(l.d_int);
       if (it!=d_litIntMap.end())
       {
         return it->second.getValue();
       }
-      ev = new Literal(l.d_int);
+      ev = mkNode<Literal>(l.d_int);
       d_litIntMap[l.d_int] = Expr(ev);
     }
       break;
@@ -1030,7 +1123,7 @@ ExprValue* State::mkLiteralInternal(Literal& l)
       {
         return it->second.getValue();
       }
-      ev = new Literal(k, l.d_rat);
+      ev = mkNode<Literal>(k, l.d_rat);
       m[l.d_rat] = Expr(ev);
     }
       break;
@@ -1044,7 +1137,7 @@ ExprValue* State::mkLiteralInternal(Literal& l)
       {
         return it->second.getValue();
       }
-      ev = new Literal(k, l.d_bv);
+      ev = mkNode<Literal>(k, l.d_bv);
       m[l.d_bv] = Expr(ev);
     }
       break;
@@ -1055,7 +1148,7 @@ ExprValue* State::mkLiteralInternal(Literal& l)
       {
         return it->second.getValue();
       }
-      ev = new Literal(l.d_str);
+      ev = mkNode<Literal>(l.d_str);
       d_litStrMap[l.d_str] = Expr(ev);
     }
       break;
@@ -1071,6 +1164,11 @@ ExprValue* State::mkLiteralInternal(Literal& l)
 ExprValue* State::mkApplyInternal(const std::vector<ExprValue*>& children)
 {
   Assert(children.size() > 2);
+  if (d_opts.d_naryApply)
+  {
+    // a single n-ary application
+    return mkExprInternal(Kind::APPLY, children);
+  }
   // requires currying
   ExprValue* curr = children[0];
   for (size_t i=1, nchildren = children.size(); i<nchildren; i++)
@@ -1083,20 +1181,44 @@ ExprValue* State::mkApplyInternal(const std::vector<ExprValue*>& children)
 ExprValue* State::mkExprInternal(Kind k,
                                  const std::vector<ExprValue*>& children)
 {
+  if (k==Kind::APPLY && d_opts.d_naryApply)
+  {
+    // ((f a1 ... an) b1 ... bm) is stored as (f a1 ... an b1 ... bm), which
+    // does not apply to programs and proof rules, whose types are not curried.
+    ExprValue* hd = children[0];
+    if (hd->getKind()==Kind::APPLY && !isNonCurriedSymbol((*hd)[0]->getKind()))
+    {
+      ExprSpan hchildren = hd->getChildren();
+      std::vector<ExprValue*> nchildren(hchildren.begin(), hchildren.end());
+      nchildren.insert(nchildren.end(), children.begin()+1, children.end());
+      return mkExprInternal(k, nchildren);
+    }
+  }
   d_stats.d_mkExprCount++;
-  ExprTrie* et = &d_trie[k];
-  et = et->get(children);
-  if (et->d_data!=nullptr)
+  size_t h = ExprTable::computeHash(k, children);
+  ExprValue* ev = d_exprTable.find(k, children, h);
+  if (ev!=nullptr)
   {
-    return et->d_data;
+    return ev;
   }
   d_stats.d_exprCount++;
-  ExprValue* ev = new ExprValue(k, children);
+  // the children of ev are stored inline
+  void* mem = d_alloc.allocate(ExprValue::getAllocSize(children.size()));
+  ev = new (mem) ExprValue(k, children);
   Trace("gc") << "New " << ev << " " << k << std::endl;
-  et->d_data = ev;
+  d_exprTable.insert(ev, h);
   return ev;
 }
 
+Expr& State::getSymbolEntry(std::vector<Expr>& t, uint32_t id)
+{
+  if (id >= t.size())
+  {
+    t.resize(id + 1);
+  }
+  return t[id];
+}
+
 bool State::bind(const std::string& name, const Expr& e)
 {
   // compiler is agnostic to which symbol table, record it here
@@ -1104,32 +1226,34 @@ bool State::bind(const std::string& name, const Expr& e)
   {
     d_plugin->bind(name, e);
   }
+  uint32_t id = d_symbols.intern(name);
   // if using a separate symbol table for rules
   if (d_opts.d_ruleSymTable && e.getKind() == Kind::PROOF_RULE)
   {
     // don't bind at non-global scope
     Assert (d_declsSizeCtx.empty());
-    if (d_ruleSymTable.find(name)!=d_ruleSymTable.end())
+    Expr& rentry = getSymbolEntry(d_ruleSymTable, id);
+    if (!rentry.isNull())
     {
       return false;
     }
-    d_ruleSymTable[name] = e;
+    rentry = e;
     return true;
   }
   // otherwise use the main symbol table
-  std::map<std::string, Expr>::iterator its = d_symTable.find(name);
-  if (its!=d_symTable.end())
+  Expr& entry = getSymbolEntry(d_symTable, id);
+  if (!entry.isNull())
   {
     Trace("overload") << "** overload: " << name << std::endl;
     // if already bound, we overload
-    AppInfo& ai = d_appData[its->second.getValue()];
+    AppInfo& ai = mkAppInfo(entry.getValue());
     std::vector<Expr>& ov = ai.d_overloads;
-    AppInfo& ain = d_appData[e.getValue()];
+    AppInfo& ain = mkAppInfo(e.getValue());
     std::vector<Expr>& ovn = ain.d_overloads;
     if (ov.empty())
     {
       // if first time overloading, add the original symbol
-      ovn.emplace_back(its->second);
+      ovn.emplace_back(entry);
     }
     else
     {
@@ -1143,15 +1267,15 @@ bool State::bind(const std::string& name, const Expr& e)
     // add to declaration
     if (!d_declsSizeCtx.empty())
     {
-      d_overloadedDecls.emplace_back(name);
+      d_overloadedDecls.emplace_back(id);
     }
   }
   // Trace("state-debug") << "bind " << name << " -> " << &e << std::endl;
-  d_symTable[name] = e;
+  entry = e;
   // only have to remember if not at global scope
   if (!d_declsSizeCtx.empty())
   {
-    d_decls.emplace_back(name);
+    d_decls.emplace_back(id);
   }
   return true;
 }
@@ -1159,10 +1283,10 @@ bool State::bind(const std::string& name, const Expr& e)
 Expr State::mkBinderList(const ExprValue* ev, const std::vector<Expr>& vs)
 {
   Assert (!vs.empty());
-  std::map<const ExprValue *, AppInfo>::const_iterator it = d_appData.find(ev);
-  Assert (it!=d_appData.end());
+  const AppInfo* ai = getAppInfo(ev);
+  Assert (ai!=nullptr);
   std::vector<Expr> vlist;
-  vlist.push_back(it->second.d_attrConsTerm);
+  vlist.push_back(ai->d_attrConsTerm);
   vlist.insert(vlist.end(), vs.begin(), vs.end());
   return mkExpr(Kind::APPLY, vlist);
 }
@@ -1170,9 +1294,9 @@ Expr State::mkBinderList(const ExprValue* ev, const std::vector<Expr>& vs)
 Expr State::mkLetBinderList(const ExprValue* ev, const std::vector<std::pair<Expr, Expr>>& lls)
 {
   Assert (!lls.empty());
-  std::map<const ExprValue *, AppInfo>::const_iterator it = d_appData.find(ev);
-  Assert (it!=d_appData.end());
-  Expr cons = it->second.d_attrConsTerm;
+  const AppInfo* ai = getAppInfo(ev);
+  Assert (ai!=nullptr);
+  Expr cons = ai->d_attrConsTerm;
   Assert (cons.getKind()==Kind::TUPLE && cons.getNumChildren()==2);
   Expr pairCons = cons[0];
   Expr listCons = cons[1];
@@ -1207,20 +1331,21 @@ Attr State::getConstructorKind(const ExprValue* v) const
 }
 
 
-Expr State::getVar(const std::string& name) const
+Expr State::getVar(std::string_view name) const
 {
-  std::map<std::string, Expr>::const_iterator it = d_symTable.find(name);
-  if (it!=d_symTable.end())
+  uint32_t id = d_symbols.find(name);
+  if (id < d_symTable.size())
   {
-    return it->second;
+    return d_symTable[id];
   }
   return d_null;
 }
 
 Expr State::getBoundVar(const std::string& name, const Expr& type)
 {
-  std::pair<std::string, const ExprValue*> key(name, type.getValue());
-  std::map<std::pair<std::string, const ExprValue*>, Expr>::iterator it = d_boundVars.find(key);
+  std::pair<uint32_t, const ExprValue*> key(d_symbols.intern(name),
+                                            type.getValue());
+  std::map<std::pair<uint32_t, const ExprValue*>, Expr>::iterator it = d_boundVars.find(key);
   if (it!=d_boundVars.end())
   {
     return it->second;
@@ -1230,13 +1355,13 @@ Expr State::getBoundVar(const std::string& name, const Expr& type)
   return ret;
 }
 
-Expr State::getProofRule(const std::string& name) const
+Expr State::getProofRule(std::string_view name) const
 {
-  const std::map<std::string, Expr>& t = d_opts.d_ruleSymTable ? d_ruleSymTable : d_symTable;
-  std::map<std::string, Expr>::const_iterator it = t.find(name);
-  if (it!=t.end())
+  const std::vector<Expr>& t = d_opts.d_ruleSymTable ? d_ruleSymTable : d_symTable;
+  uint32_t id = d_symbols.find(name);
+  if (id < t.size())
   {
-    return it->second;
+    return t[id];
   }
   return d_null;
 }
@@ -1303,6 +1428,15 @@ Expr State::getProgram(const ExprValue* ev)
   }
   return d_null;
 }
+const ProgramIndex* State::getProgramIndex(const ExprValue* ev)
+{
+  AppInfo* ainfo = getAppInfo(ev);
+  if (ainfo!=nullptr && ainfo->d_attrCons==Attr::PROGRAM)
+  {
+    return ainfo->d_progIndex.get();
+  }
+  return nullptr;
+}
 bool State::getOracleCmd(const ExprValue* oracle, std::string& ocmd)
 {
   AppInfo* ainfo = getAppInfo(oracle);
@@ -1330,14 +1464,17 @@ std::vector<Expr> State::getCurrentAssumptions() const
 
 size_t State::getHash(const ExprValue* e)
 {
-  std::map<const ExprValue*, size_t>::const_iterator it = d_hashMap.find(e);
-  if (it!=d_hashMap.end())
+  if (e->getFlag(ExprValue::Flag::HAS_HASH))
   {
+    std::unordered_map<const ExprValue*, size_t>::const_iterator it =
+        d_hashMap.find(e);
+    Assert(it != d_hashMap.end());
     return it->second;
   }
   d_hashCounter++;
   size_t ret = d_hashCounter;
   d_hashMap[e] = ret;
+  const_cast<ExprValue*>(e)->setFlag(ExprValue::Flag::HAS_HASH, true);
   return ret;
 }
 
@@ -1359,33 +1496,45 @@ bool State::isProofRuleSorry(const ExprValue* e) const
 AppInfo* State::getAppInfo(const ExprValue* e)
 {
   Assert (e->getKind()!=Kind::PARAMETERIZED);
-  std::map<const ExprValue *, AppInfo>::iterator it = d_appData.find(e);
-  if (it!=d_appData.end())
+  if (!e->getFlag(ExprValue::Flag::HAS_APP_INFO))
   {
-    return &it->second;
+    return nullptr;
   }
-  return nullptr;
+  std::unordered_map<const ExprValue*, AppInfo>::iterator it = d_appData.find(e);
+  Assert(it != d_appData.end());
+  return &it->second;
 }
 
 const AppInfo* State::getAppInfo(const ExprValue* e) const
 {
   Assert (e->getKind()!=Kind::PARAMETERIZED);
-  std::map<const ExprValue *, AppInfo>::const_iterator it = d_appData.find(e);
-  if (it!=d_appData.end())
+  if (!e->getFlag(ExprValue::Flag::HAS_APP_INFO))
   {
-    return &it->second;
+    return nullptr;
   }
-  return nullptr;
+  std::unordered_map<const ExprValue*, AppInfo>::const_iterator it =
+      d_appData.find(e);
+  Assert(it != d_appData.end());
+  return &it->second;
+}
+
+AppInfo& State::mkAppInfo(ExprValue* e)
+{
+  e->setFlag(ExprValue::Flag::HAS_APP_INFO, true);
+  return d_appData[e];
+}
+
+void State::setType(ExprValue* e, ExprValue* t)
+{
+  Assert(e->d_type == nullptr);
+  Assert(t != nullptr && !t->isNull());
+  t->inc();
+  e->d_type = t;
 }
 
 ExprValue* State::lookupType(const ExprValue* e) const
 {
-  std::map<const ExprValue*, Expr>::const_iterator itt = d_typeCache.find(e);
-  if (itt != d_typeCache.end())
-  {
-    return itt->second.getValue();
-  }
-  return nullptr;
+  return e->d_type;
 }
 
 TypeChecker& State::getTypeChecker()
@@ -1417,6 +1566,8 @@ Plugin* State::getPlugin()
   return d_plugin;
 }
 
+const SlabAllocator& State::getAllocator() const { return d_alloc; }
+
 void State::bindBuiltin(const std::string& name, Kind k, Attr ac)
 {
   // type is irrelevant, assign abstract
@@ -1430,7 +1581,7 @@ void State::bindBuiltin(const std::string& name, Kind k, Attr ac, const Expr& t)
   if (ac!=Attr::NONE || k!=Kind::NONE)
   {
     // associate the information
-    AppInfo& ai = d_appData[c.getValue()];
+    AppInfo& ai = mkAppInfo(c.getValue());
     ai.d_kind = k;
     ai.d_attrCons = ac;
   }
@@ -1444,10 +1595,19 @@ void State::bindBuiltinEval(const std::string& name, Kind k, Attr ac)
 void State::defineProgram(const Expr& v, const Expr& prog)
 {
   markConstructorKind(v, Attr::PROGRAM, prog);
+  AppInfo& ai = mkAppInfo(v.getValue());
+  ai.d_progIndex.reset(new ProgramIndex(prog));
+  // applications of v may have been memoized before it was defined, e.g. if
+  // it was declared beforehand, in which case they did not evaluate
+  d_tc.d_progMemo.erase(v.getValue());
   if (d_plugin!=nullptr)
   {
     d_plugin->defineProgram(v, prog);
   }
+  else if (d_opts.d_evalVm)
+  {
+    d_tc.d_vm.compileProgram(prog);
+  }
 }
 
 bool State::markConstructorKind(const Expr& v, Attr a, const Expr& cons)
@@ -1471,7 +1631,7 @@ bool State::markConstructorKind(const Expr& v, Attr a, const Expr& cons)
     acons = mkLiteral(Kind::STRING, inputPath.getRawPath());
   }
   Assert (isSymbol(v.getKind()));
-  AppInfo& ai = d_appData[v.getValue()];
+  AppInfo& ai = mkAppInfo(v.getValue());
   Assert (ai.d_attrCons==Attr::NONE);
   ai.d_attrCons = a;
   ai.d_attrConsTerm = acons;
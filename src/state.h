@@ -10,17 +10,22 @@
 #define STATE_H
 
 #include <map>
+#include <new>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "attr.h"
 #include "plugin.h"
 #include "expr.h"
 #include "expr_info.h"
-#include "expr_trie.h"
+#include "expr_table.h"
+#include "list_cache.h"
 #include "literal.h"
+#include "slab_allocator.h"
 #include "stats.h"
+#include "symbol_pool.h"
 #include "type_checker.h"
 #include "util/filesystem.h"
 
@@ -39,6 +44,8 @@ class Options
   bool d_parseLet;
   bool d_stats;
   bool d_statsCompact;
+  /** Print the occupancy of the expression allocator in the statistics */
+  bool d_statsAlloc;
   bool d_ruleSymTable;
   bool d_normalizeDecimal;
   bool d_normalizeHexadecimal;
@@ -46,6 +53,32 @@ class Options
   bool d_normalizeNumeral;
   /** Binders generate fresh variables in proof and reference files */
   bool d_binderFresh;
+  /**
+   * Applications (f a1 ... an) of curried functions are stored as a single
+   * n-ary APPLY node instead of n nested binary APPLY nodes.
+   */
+  bool d_naryApply;
+  /** The conclusions of proof rules are cached by rule and context */
+  bool d_instCache;
+  /**
+   * Results of applications of programs to ground arguments are memoized
+   * across evaluations.
+   */
+  bool d_progMemo;
+  /** The maximum number of entries in the memo table for programs */
+  size_t d_progMemoSize;
+  /** Programs and type rules are evaluated by a bytecode interpreter */
+  bool d_evalVm;
+  /**
+   * Input on stdin is read in blocks by a reader thread, which is the default
+   * if stdin is not a terminal.
+   */
+  bool d_stdinPiped;
+  /**
+   * Files are lexed by a separate thread, ahead of the commands that are
+   * being checked.
+   */
+  bool d_pipelineParse;
 };
 
 /**
@@ -55,6 +88,8 @@ class State
 {
   friend class TypeChecker;
   friend class ExprValue;
+  friend class Vm;
+  friend class Executor;
 
  public:
   State(Options& opts, Stats& stats);
@@ -153,20 +188,22 @@ class State
   /** */
   Expr mkLetBinderList(const ExprValue* ev, const std::vector<std::pair<Expr, Expr>>& lls);
   /** Get the variable with the given name or nullptr if it does not exist */
-  Expr getVar(const std::string& name) const;
+  Expr getVar(std::string_view name) const;
   /**
    * Get the bound variable with the given type. This method always returns the
    * same variable for the same name and type.
    */
   Expr getBoundVar(const std::string& name, const Expr& type);
   /** Get the proof rule with the given name or nullptr if it does not exist */
-  Expr getProofRule(const std::string& name) const;
+  Expr getProofRule(std::string_view name) const;
   /** Get actual premises */
   bool getActualPremises(const ExprValue* ev,
                          std::vector<Expr>& given,
                          std::vector<Expr>& actual);
   /** Get the program */
   Expr getProgram(const ExprValue* ev);
+  /** Get the index of the cases of the program, or nullptr if not defined */
+  const ProgramIndex* getProgramIndex(const ExprValue* ev);
   /** Get the oracle command */
   bool getOracleCmd(const ExprValue* ev, std::string& ocmd);
   /** */
@@ -200,8 +237,15 @@ class State
   void setPlugin(Plugin* p);
   /** Get plugin */
   Plugin* getPlugin();
+  /** Get the allocator for expressions */
+  const SlabAllocator& getAllocator() const;
 
  private:
+  /**
+   * The allocator for expressions. This is declared first so that it is
+   * destroyed after all other members that may reference expressions.
+   */
+  SlabAllocator d_alloc;
   /** Common constants */
   Expr d_null;
   Expr d_type;
@@ -217,11 +261,23 @@ class State
   Expr d_listCons;
   /** Get base operator */
   const ExprValue* getBaseOperator(const ExprValue * v) const;
-  /** Mark that file s was included */
+  /** Mark that file s, given by its real path, was included */
   bool markIncluded(const Filepath& s);
   /** mark deleted */
   void markDeleted(ExprValue* e);
-  /** Make (<APPLY> children), curried. */
+  /**
+   * Construct a new expression of type T using the allocator. This is used
+   * for expressions without children, e.g. literals.
+   */
+  template <typename T, typename... Args>
+  T* mkNode(Args&&... args)
+  {
+    return new (d_alloc.allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+  /**
+   * Make (<APPLY> children), which is curried unless the option naryApply is
+   * true, in which case it is a single n-ary application.
+   */
   ExprValue* mkApplyInternal(const std::vector<ExprValue*>& children);
   /**
    * Constructs a new expression from k and children, or returns a
@@ -253,23 +309,35 @@ class State
   /** Get the internal data for expression e. */
   AppInfo* getAppInfo(const ExprValue* e);
   const AppInfo* getAppInfo(const ExprValue* e) const;
+  /** Get the internal data for expression e, constructing it if necessary. */
+  AppInfo& mkAppInfo(ExprValue* e);
+  /** Set the type of e to t, where the type of e was not yet set. */
+  void setType(ExprValue* e, ExprValue* t);
   /** Bind builtin */
   void bindBuiltin(const std::string& name, Kind k, Attr ac = Attr::NONE);
   /** Bind builtin */
   void bindBuiltin(const std::string& name, Kind k, Attr ac, const Expr& t);
   /** Bind builtin eval */
   void bindBuiltinEval(const std::string& name, Kind k, Attr ac = Attr::NONE);
+  /** Get the entry for the symbol with the given identifier in table t */
+  static Expr& getSymbolEntry(std::vector<Expr>& t, uint32_t id);
   //--------------------- parsing state
-  /** The symbol table, mapping symbols */
-  std::map<std::string, Expr> d_symTable;
+  /** The names of all symbols that have been bound */
+  SymbolPool d_symbols;
+  /**
+   * The symbol table, mapping the identifiers of symbols in d_symbols to
+   * their binding, which is null if the symbol is not bound.
+   */
+  std::vector<Expr> d_symTable;
   /** Symbol table for proof rules, if using separate table */
-  std::map<std::string, Expr> d_ruleSymTable;
+  std::vector<Expr> d_ruleSymTable;
   /** The (canonical) bound variables for binders */
-  std::map<std::pair<std::string, const ExprValue*>, Expr> d_boundVars;
+  std::map<std::pair<uint32_t, const ExprValue*>, Expr> d_boundVars;
   /**
-   * The list of declared symbols in the order they were bound.
+   * The list of declared symbols in the order they were bound, which is used
+   * as an undo trail when popping scopes.
    */
-  std::vector<std::string> d_decls;
+  std::vector<uint32_t> d_decls;
   /**
    * The list of declared symbols that were overloaded when they
    * were bound. This is a sublist of d_decls. For example if
@@ -277,7 +345,7 @@ class State
    * then
    *   d_overloadedDecls = { "A", "A", "B" }.
    */
-  std::vector<std::string> d_overloadedDecls;
+  std::vector<uint32_t> d_overloadedDecls;
   /**
    * Context size, which is the size of d_decls at the time of when each
    * current pushScope was called.
@@ -288,21 +356,34 @@ class State
   /** Context size */
   std::vector<size_t> d_assumptionsSizeCtx;
   //--------------------- expression info
-  /** Map from expressions to constructor info */
-  std::map<const ExprValue*, AppInfo> d_appData;
-  /** Map from expressions to hash */
-  std::map<const ExprValue*, size_t> d_hashMap;
-  /** Mapping expressions to types */
-  std::map<const ExprValue*, Expr> d_typeCache;
+  /**
+   * Map from expressions to constructor info. An expression has an entry in
+   * this map if and only if it has the flag HAS_APP_INFO, hence expressions
+   * without constructor info never require a lookup. Note the types of
+   * expressions are stored in ExprValue::d_type.
+   */
+  std::unordered_map<const ExprValue*, AppInfo> d_appData;
+  /**
+   * Map from expressions to hash. As above, only expressions with the flag
+   * HAS_HASH have an entry in this map.
+   */
+  std::unordered_map<const ExprValue*, size_t> d_hashMap;
+  /**
+   * Cache of information about lists, used by list operators. As above, only
+   * expressions with the flag HAS_LIST_CACHE have entries in this cache.
+   */
+  ListCache d_listCache;
   /** Hash counter */
   size_t d_hashCounter;
   /** The database of created expressions */
-  std::map<Kind, ExprTrie> d_trie;
+  ExprTable d_exprTable;
   //--------------------- literals
   /** Cache for literals */
   std::unordered_map<Rational, Expr, RationalHashFunction> d_litRatMap[2];
   std::unordered_map<String, Expr, StringHashFunction> d_litStrMap;
   std::unordered_map<Integer, Expr, IntegerHashFunction> d_litIntMap;
+  /** Cache for numerals that fit into 64 bits, keyed by their value */
+  std::unordered_map<int64_t, Expr> d_litSmallIntMap;
   std::unordered_map<BitVector, Expr, BitVectorHashFunction> d_litBvMap[2];
   // -------------------- symbols
   /** Cache for symbols */
@@ -22,7 +22,8 @@ namespace ethos {
 std::time_t RuleStat::d_startTime;
 size_t RuleStat::d_startMkExprCount;
   
-RuleStat::RuleStat() : d_count(0), d_mkExprCount(0), d_time(0)
+RuleStat::RuleStat()
+    : d_count(0), d_mkExprCount(0), d_time(0), d_instLookups(0), d_instHits(0)
 {
 }
 
@@ -39,6 +40,19 @@ void RuleStat::increment(Stats& s)
   d_time += (Stats::getCurrentTime()-d_startTime);
 }
   
+std::string RuleStat::instHitRate() const
+{
+  if (d_instLookups == 0)
+  {
+    return "-";
+  }
+  std::stringstream ss;
+  double pct = static_cast<double>(100 * d_instHits)
+               / static_cast<double>(d_instLookups);
+  ss << std::fixed << std::setprecision(1) << pct << "%";
+  return ss.str();
+}
+
 std::string RuleStat::toString(std::time_t totalTime) const
 {
   std::stringstream ss;
@@ -57,10 +71,26 @@ std::string RuleStat::toString(std::time_t totalTime) const
   std::stringstream se;
   se << d_mkExprCount;
   ss << std::left << std::setw(10) << se.str();
+  ss << std::left << std::setw(8) << instHitRate();
   return ss.str();
 }
   
-Stats::Stats() : d_mkExprCount(0), d_exprCount(0), d_deleteExprCount(0), d_symCount(0), d_litCount(0)
+Stats::Stats()
+    : d_mkExprCount(0),
+      d_exprCount(0),
+      d_deleteExprCount(0),
+      d_symCount(0),
+      d_litCount(0),
+      d_hashConsLookups(0),
+      d_hashConsProbes(0),
+      d_hashConsMaxProbe(0),
+      d_programCalls(0),
+      d_programCasesTried(0),
+      d_progMemoHits(0),
+      d_progMemoMisses(0),
+      d_progMemoEvictions(0),
+      d_evalMaxDepth(0),
+      d_evalMaxFrameBytes(0)
 {
   d_startTime = getCurrentTime();
 }
@@ -95,6 +125,36 @@ std::string Stats::toString(State& s, bool compact) const
   ss << "deleteExprCount = " << d_deleteExprCount << std::endl;
   ss << "symCount = " << d_symCount << std::endl;
   ss << "litCount = " << d_litCount << std::endl;
+  ss << "hashConsLookups = " << d_hashConsLookups << std::endl;
+  double avgProbe = d_hashConsLookups == 0
+                        ? 0.0
+                        : static_cast<double>(d_hashConsProbes)
+                              / static_cast<double>(d_hashConsLookups);
+  std::stringstream sp;
+  sp << std::fixed << std::setprecision(2) << avgProbe;
+  ss << "hashConsProbes = " << d_hashConsProbes << " (avg " << sp.str()
+     << ", max " << d_hashConsMaxProbe << ")" << std::endl;
+  ss << "programCalls = " << d_programCalls << std::endl;
+  double avgCases = d_programCalls == 0
+                        ? 0.0
+                        : static_cast<double>(d_programCasesTried)
+                              / static_cast<double>(d_programCalls);
+  std::stringstream spc;
+  spc << std::fixed << std::setprecision(2) << avgCases;
+  ss << "programCasesTried = " << d_programCasesTried << " (avg " << spc.str()
+     << " per call)" << std::endl;
+  ss << "evalMaxDepth = " << d_evalMaxDepth << std::endl;
+  ss << "evalMaxFrameBytes = " << d_evalMaxFrameBytes << std::endl;
+  if (s.getOptions().d_progMemo)
+  {
+    ss << "progMemoHits = " << d_progMemoHits << std::endl;
+    ss << "progMemoMisses = " << d_progMemoMisses << std::endl;
+    ss << "progMemoEvictions = " << d_progMemoEvictions << std::endl;
+  }
+  if (s.getOptions().d_statsAlloc)
+  {
+    ss << s.getAllocator().toString();
+  }
   std::time_t totalTime = (getCurrentTime()-d_startTime);
   ss << "time = " << totalTime << std::endl;
   if (!d_rstats.empty())
@@ -107,6 +167,7 @@ std::string Stats::toString(State& s, bool compact) const
       ss << std::left << std::setw(7) << "#";
       ss << std::left << std::setw(10) << "t/#";
       ss << std::left << std::setw(10) << "#mkExpr";
+      ss << std::left << std::setw(8) << "inst";
       ss << std::endl;
       ss << "========================================================================" << std::endl;
     }
@@ -122,6 +183,7 @@ std::string Stats::toString(State& s, bool compact) const
     std::map<const ExprValue*, RuleStat>::const_iterator itr;
     std::stringstream ssCheck;
     std::stringstream ssMkExpr;
+    std::stringstream ssInst;
     bool firstTime = true;
     for (const ExprValue* e : sortedStats)
     {
@@ -141,9 +203,11 @@ std::string Stats::toString(State& s, bool compact) const
         {
           ssCheck << ", ";
           ssMkExpr << ", ";
+          ssInst << ", ";
         }
         ssCheck << sss.str() << ": " << rs.d_time;
         ssMkExpr << sss.str() << ": " << rs.d_mkExprCount;
+        ssInst << sss.str() << ": " << rs.instHitRate();
       }
       else
       {
@@ -155,6 +219,7 @@ std::string Stats::toString(State& s, bool compact) const
     {
       ss << "checkTime = { " << ssCheck.str() << " }" << std::endl;
       ss << "mkExpr = { " << ssMkExpr.str() << " }" << std::endl;
+      ss << "instHits = { " << ssInst.str() << " }" << std::endl;
     }
   }
   return ss.str();
@@ -27,11 +27,16 @@ class RuleStat
   size_t d_count;
   size_t d_mkExprCount;
   std::time_t d_time;
+  /** Lookups of the conclusion in the instantiation cache, and their hits */
+  size_t d_instLookups;
+  size_t d_instHits;
   void increment(Stats& s);
   // frame
   static std::time_t d_startTime;
   static size_t d_startMkExprCount;
   static void start(Stats& s);
+  /** The hit rate of the instantiation cache, as a percentage */
+  std::string instHitRate() const;
   std::string toString(std::time_t totalTime) const;
 };
 
@@ -44,6 +49,20 @@ public:
   size_t d_deleteExprCount;
   size_t d_symCount;
   size_t d_litCount;
+  /** Lookups in the hash-consing table, and the probes they required */
+  size_t d_hashConsLookups;
+  size_t d_hashConsProbes;
+  size_t d_hashConsMaxProbe;
+  /** Calls to programs, and the cases that were matched against */
+  size_t d_programCalls;
+  size_t d_programCasesTried;
+  /** Lookups in the memo table for programs, and entries evicted from it */
+  size_t d_progMemoHits;
+  size_t d_progMemoMisses;
+  size_t d_progMemoEvictions;
+  /** The maximum depth and memory in bytes of the frames of evaluate */
+  size_t d_evalMaxDepth;
+  size_t d_evalMaxFrameBytes;
   std::time_t d_startTime;
   std::map<const ExprValue*, RuleStat> d_rstats;
   std::string toString(State& s, bool compact) const;
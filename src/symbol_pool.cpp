@@ -0,0 +1,50 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "symbol_pool.h"
+
+#include "base/check.h"
+
+namespace ethos {
+
+SymbolPool::SymbolPool() {}
+
+SymbolPool::~SymbolPool() {}
+
+uint32_t SymbolPool::intern(std::string_view name)
+{
+  std::unordered_map<std::string_view, uint32_t>::iterator it =
+      d_ids.find(name);
+  if (it != d_ids.end())
+  {
+    return it->second;
+  }
+  uint32_t id = static_cast<uint32_t>(d_names.size());
+  Assert(id != s_none);
+  d_names.emplace_back(name);
+  // the key must view the stored copy of the name
+  d_ids[d_names.back()] = id;
+  return id;
+}
+
+uint32_t SymbolPool::find(std::string_view name) const
+{
+  std::unordered_map<std::string_view, uint32_t>::const_iterator it =
+      d_ids.find(name);
+  return it == d_ids.end() ? s_none : it->second;
+}
+
+const std::string& SymbolPool::getName(uint32_t id) const
+{
+  Assert(id < d_names.size());
+  return d_names[id];
+}
+
+size_t SymbolPool::size() const { return d_names.size(); }
+
+}  // namespace ethos
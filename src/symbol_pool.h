@@ -0,0 +1,53 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef SYMBOL_POOL_H
+#define SYMBOL_POOL_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ethos {
+
+/**
+ * A pool of interned symbol names.
+ *
+ * Each distinct name is assigned a unique identifier, which is a dense index
+ * starting from zero. Names are stored once and are never removed, so
+ * identifiers and references to names remain valid for the lifetime of the
+ * pool.
+ */
+class SymbolPool
+{
+ public:
+  SymbolPool();
+  ~SymbolPool();
+  /** The identifier returned by find for names that are not in this pool */
+  static const uint32_t s_none = UINT32_MAX;
+  /** Get the identifier for name, adding it to this pool if necessary. */
+  uint32_t intern(std::string_view name);
+  /** Get the identifier for name, or s_none if it is not in this pool. */
+  uint32_t find(std::string_view name) const;
+  /** Get the name with the given identifier. */
+  const std::string& getName(uint32_t id) const;
+  /** Get the number of names in this pool. */
+  size_t size() const;
+
+ private:
+  /** The names, indexed by identifier, which do not move once added */
+  std::deque<std::string> d_names;
+  /** Maps views of the strings in d_names to their identifier */
+  std::unordered_map<std::string_view, uint32_t> d_ids;
+};
+
+}  // namespace ethos
+
+#endif /* SYMBOL_POOL_H */
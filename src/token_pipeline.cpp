@@ -0,0 +1,164 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "token_pipeline.h"
+
+namespace ethos {
+
+TokenPipeline::TokenPipeline(Input* input,
+                             const std::string& inputName,
+                             bool lexLet)
+    : d_lex(lexLet),
+      d_data(input->getData()),
+      d_stop(false),
+      d_waiting(false),
+      d_pos(0)
+{
+  d_lex.initialize(input, inputName);
+  // errors are passed to the parser
+  d_lex.d_deferErrors = true;
+  d_thread = std::thread(&TokenPipeline::run, this);
+}
+
+TokenPipeline::~TokenPipeline()
+{
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_stop = true;
+  }
+  d_cvSpace.notify_one();
+  d_thread.join();
+}
+
+std::unique_ptr<TokenPipeline::Batch> TokenPipeline::allocBatch()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  if (d_free.empty())
+  {
+    return std::unique_ptr<Batch>(new Batch);
+  }
+  std::unique_ptr<Batch> b = std::move(d_free.back());
+  d_free.pop_back();
+  return b;
+}
+
+bool TokenPipeline::push(std::unique_ptr<Batch>& b)
+{
+  {
+    std::unique_lock<std::mutex> lock(d_mutex);
+    d_cvSpace.wait(
+        lock, [this]() { return d_stop || d_ready.size() < s_maxBatches; });
+    if (d_stop)
+    {
+      return false;
+    }
+    d_ready.push_back(std::move(b));
+    // the parser has a batch to consume
+    d_waiting.store(false, std::memory_order_relaxed);
+  }
+  d_cvReady.notify_one();
+  return true;
+}
+
+void TokenPipeline::run()
+{
+  std::unique_ptr<Batch> b = allocBatch();
+  // the depth of parentheses, so that batches end at commands
+  size_t depth = 0;
+  for (;;)
+  {
+    Token t = d_lex.nextToken();
+    std::string_view text = d_lex.tokenView();
+    Entry e;
+    e.d_token = t;
+    e.d_span = d_lex.d_span;
+    e.d_textSize = text.size();
+    if (d_data != nullptr)
+    {
+      // the token is a range of the input
+      e.d_textBegin = static_cast<size_t>(text.data() - d_data);
+    }
+    else
+    {
+      e.d_textBegin = b->d_text.size();
+      b->d_text.insert(b->d_text.end(), text.begin(), text.end());
+    }
+    b->d_entries.push_back(e);
+    if (t == Token::LPAREN)
+    {
+      depth++;
+    }
+    else if (t == Token::RPAREN && depth > 0)
+    {
+      depth--;
+    }
+    else if (t == Token::EOF_TOK || t == Token::NONE)
+    {
+      b->d_error = d_lex.d_error;
+      push(b);
+      return;
+    }
+    if (depth == 0
+        && (b->d_entries.size() >= s_batchSize
+            || d_waiting.load(std::memory_order_relaxed)))
+    {
+      if (!push(b))
+      {
+        return;
+      }
+      b = allocBatch();
+    }
+  }
+}
+
+Token TokenPipeline::nextToken(Span& span, std::string_view& text)
+{
+  if (d_current == nullptr || d_pos == d_current->d_entries.size())
+  {
+    std::unique_lock<std::mutex> lock(d_mutex);
+    if (d_current != nullptr)
+    {
+      d_current->d_entries.clear();
+      d_current->d_text.clear();
+      d_free.push_back(std::move(d_current));
+    }
+    if (d_ready.empty())
+    {
+      d_waiting.store(true, std::memory_order_relaxed);
+      d_cvReady.wait(lock, [this]() { return !d_ready.empty(); });
+    }
+    d_current = std::move(d_ready.front());
+    d_ready.pop_front();
+    d_pos = 0;
+    // wake the lexing thread only once the queue is half empty, so that it
+    // lexes several batches at a time
+    bool wake = (d_ready.size() == s_maxBatches / 2);
+    lock.unlock();
+    if (wake)
+    {
+      d_cvSpace.notify_one();
+    }
+  }
+  const Entry& e = d_current->d_entries[d_pos];
+  // the last token is returned by all further calls
+  if (e.d_token != Token::EOF_TOK && e.d_token != Token::NONE)
+  {
+    d_pos++;
+  }
+  span = e.d_span;
+  const char* data = d_data != nullptr ? d_data : d_current->d_text.data();
+  text = std::string_view(data + e.d_textBegin, e.d_textSize);
+  return e.d_token;
+}
+
+const std::string& TokenPipeline::getError() const
+{
+  return d_current->d_error;
+}
+
+}  // namespace ethos
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef TOKEN_PIPELINE_H
+#define TOKEN_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "lexer.h"
+
+namespace ethos {
+
+/**
+ * Lexes an input on a separate thread, ahead of the parser that consumes its
+ * tokens.
+ *
+ * The tokens are passed to the parser in batches through a bounded queue.
+ * Batches end at the boundary of a top-level s-expression, i.e. a command,
+ * once they contain enough tokens or the parser is waiting for the next
+ * batch. Errors found by the lexer are not reported by the lexing thread,
+ * but are instead passed to the parser as a token Token::NONE, so that they
+ * are reported after the commands that precede them are processed.
+ */
+class TokenPipeline
+{
+ public:
+  TokenPipeline(Input* input, const std::string& inputName, bool lexLet);
+  ~TokenPipeline();
+  /**
+   * Get the next token, and set span and text to its span and characters. The
+   * characters remain valid until the next call to this method. Once the end
+   * of the input or an error is reached, the same token is returned by all
+   * further calls.
+   */
+  Token nextToken(Span& span, std::string_view& text);
+  /** The error message, if nextToken returned Token::NONE */
+  const std::string& getError() const;
+
+ private:
+  /** A token in a batch */
+  class Entry
+  {
+   public:
+    /** The token */
+    Token d_token;
+    /** Its span */
+    Span d_span;
+    /**
+     * The position of its characters in the input if it is in memory, or in
+     * the text of the batch otherwise
+     */
+    size_t d_textBegin;
+    /** The number of its characters */
+    size_t d_textSize;
+  };
+  /** A batch of tokens */
+  class Batch
+  {
+   public:
+    /** The tokens */
+    std::vector<Entry> d_entries;
+    /** The characters of the tokens, if the input is not in memory */
+    std::vector<char> d_text;
+    /** The error message, if the last token is Token::NONE */
+    std::string d_error;
+  };
+  /** The number of tokens after which a batch ends at the next command */
+  static const size_t s_batchSize = 4096;
+  /** The maximum number of batches in the queue */
+  static const size_t s_maxBatches = 4;
+  /** Lex the input, which is run on the lexing thread */
+  void run();
+  /** Get an empty batch */
+  std::unique_ptr<Batch> allocBatch();
+  /**
+   * Add a batch to the queue, waiting for space if it is full. Return false
+   * if the pipeline was stopped.
+   */
+  bool push(std::unique_ptr<Batch>& b);
+  /** The lexer used by the lexing thread */
+  Lexer d_lex;
+  /** The contents of the input, if it is in memory */
+  const char* d_data;
+  /** Protects the members below */
+  std::mutex d_mutex;
+  /** Notified when a batch is added to the queue */
+  std::condition_variable d_cvReady;
+  /** Notified when a batch is removed from the queue, or when stopped */
+  std::condition_variable d_cvSpace;
+  /** The batches that have not been consumed */
+  std::deque<std::unique_ptr<Batch>> d_ready;
+  /** The batches that have been consumed, to be reused */
+  std::vector<std::unique_ptr<Batch>> d_free;
+  /** Whether the pipeline is being destroyed */
+  bool d_stop;
+  /** Whether the parser is waiting for a batch */
+  std::atomic<bool> d_waiting;
+  /** The batch being consumed by the parser */
+  std::unique_ptr<Batch> d_current;
+  /** The position of the next token in d_current */
+  size_t d_pos;
+  /** The lexing thread */
+  std::thread d_thread;
+};
+
+}  // namespace ethos
+
+#endif /* TOKEN_PIPELINE_H */
@@ -8,9 +8,11 @@
  ******************************************************************************/
 #include "type_checker.h"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <unordered_map>
+#include <utility>
 
 #include "base/check.h"
 #include "base/output.h"
@@ -24,7 +26,8 @@
 
 namespace ethos {
 
-TypeChecker::TypeChecker(State& s, Options& opts) : d_state(s), d_plugin(nullptr)
+TypeChecker::TypeChecker(State& s, Options& opts)
+    : d_state(s), d_opts(opts), d_plugin(nullptr), d_vm(*this, s)
 {
   std::set<Kind> literalKinds = { Kind::BOOLEAN, Kind::NUMERAL, Kind::RATIONAL, Kind::BINARY, Kind::STRING, Kind::DECIMAL, Kind::HEXADECIMAL };
   // initialize literal kinds 
@@ -78,20 +81,17 @@ ExprValue* TypeChecker::getOrSetLiteralTypeRule(Kind k)
 
 Expr TypeChecker::getType(Expr& e, std::ostream* out)
 {
-  std::map<const ExprValue*, Expr>::iterator itt;
   std::unordered_set<ExprValue*> visited;
   std::vector<ExprValue*> toVisit;
   toVisit.push_back(e.getValue());
   ExprValue* cur;
   Expr ret;
-  std::map<const ExprValue*, Expr>& tc = d_state.d_typeCache;
   do
   {
     cur = toVisit.back();
-    itt = tc.find(cur);
-    if (itt != tc.end())
+    if (cur->d_type != nullptr)
     {
-      ret = itt->second;
+      ret = Expr(cur->d_type);
       // already computed type
       toVisit.pop_back();
       continue;
@@ -99,7 +99,8 @@ Expr TypeChecker::getType(Expr& e, std::ostream* out)
     if (visited.find(cur)==visited.end())
     {
       visited.insert(cur);
-      toVisit.insert(toVisit.end(), cur->d_children.begin(), cur->d_children.end());
+      ExprSpan children = cur->getChildren();
+      toVisit.insert(toVisit.end(), children.begin(), children.end());
     }
     else
     {
@@ -122,7 +123,11 @@ Expr TypeChecker::getType(Expr& e, std::ostream* out)
         }
         return d_null;
       }
-      tc[cur] = ret;
+      // the type may have been computed during a nested call to getType
+      if (cur->d_type == nullptr)
+      {
+        d_state.setType(cur, ret.getValue());
+      }
       Trace("type_checker")
           << "TYPE " << Expr(cur) << " : " << ret << std::endl;
       // std::cout << "...return" << std::endl;
@@ -220,19 +225,19 @@ Expr TypeChecker::getTypeInternal(ExprValue* e, std::ostream* out)
     case Kind::APPLY_OPAQUE:
     {
       Ctx ctx;
-      return getTypeAppInternal(e->d_children, ctx, out);
+      return getTypeAppInternal(e->getChildren(), ctx, out);
     }
     case Kind::LAMBDA:
     {
       std::vector<Expr> args;
-      std::vector<ExprValue*>& vars = e->d_children[0]->d_children;
+      ExprSpan vars = (*e)[0]->getChildren();
       for (ExprValue* v : vars)
       {
         ExprValue* t = d_state.lookupType(v);
         Assert(t != nullptr);
         args.emplace_back(t);
       }
-      Expr ret(d_state.lookupType(e->d_children[1]));
+      Expr ret(d_state.lookupType((*e)[1]));
       Assert(!ret.isNull());
       return d_state.mkFunctionType(args, ret);
     }
@@ -243,7 +248,7 @@ Expr TypeChecker::getTypeInternal(ExprValue* e, std::ostream* out)
       return d_state.mkType();
     case Kind::PROOF_TYPE:
     {
-      ExprValue* ctype = d_state.lookupType(e->d_children[0]);
+      ExprValue* ctype = d_state.lookupType((*e)[0]);
       Assert(ctype != nullptr);
       if (ctype->getKind()!=Kind::BOOL_TYPE)
       {
@@ -260,7 +265,7 @@ Expr TypeChecker::getTypeInternal(ExprValue* e, std::ostream* out)
       return d_state.mkType();
     case Kind::OPAQUE_TYPE:
     {
-      ExprValue* ctype = d_state.lookupType(e->d_children[0]);
+      ExprValue* ctype = d_state.lookupType((*e)[0]);
       Assert(ctype != nullptr);
       if (ctype->getKind()!=Kind::TYPE)
       {
@@ -310,7 +315,7 @@ Expr TypeChecker::getTypeInternal(ExprValue* e, std::ostream* out)
     case Kind::PARAMETERIZED:
     {
       // type of the second child
-      return Expr(d_state.lookupType(e->d_children[1]));
+      return Expr(d_state.lookupType((*e)[1]));
     }
       break;
     default:
@@ -318,7 +323,7 @@ Expr TypeChecker::getTypeInternal(ExprValue* e, std::ostream* out)
       if (isLiteralOp(k))
       {
         std::vector<ExprValue*> ctypes;
-        std::vector<ExprValue*>& children = e->d_children;
+        ExprSpan children = e->getChildren();
         for (ExprValue* c : children)
         {
           ctypes.push_back(d_state.lookupType(c));
@@ -345,7 +350,7 @@ Expr TypeChecker::getTypeApp(std::vector<Expr>& children, std::ostream* out)
   return getTypeAppInternal(vchildren, ctx, out);
 }
 
-Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
+Expr TypeChecker::getTypeAppInternal(ExprSpan children,
                                      Ctx& ctx,
                                      std::ostream* out)
 {
@@ -353,6 +358,51 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
   ExprValue* hd = children[0];
   ExprValue* hdType = d_state.lookupType(hd);
   Assert(hdType != nullptr) << "No type for " << Expr(hd);
+  if (d_opts.d_naryApply && hdType->getKind() == Kind::FUNCTION_TYPE
+      && hdType->getNumChildren() < children.size()
+      && !isNonCurriedSymbol(hd->getKind()))
+  {
+    return getTypeNaryAppInternal(children, out);
+  }
+  return getTypeAppInternal(hdType, children, ctx, out);
+}
+
+Expr TypeChecker::getTypeNaryAppInternal(ExprSpan children, std::ostream* out)
+{
+  ExprValue* hd = children[0];
+  Expr curType(d_state.lookupType(hd));
+  std::vector<ExprValue*> cc{hd};
+  // apply the arguments one function type at a time, where each step is
+  // typed in a fresh context since the return type is already instantiated.
+  size_t i = 1;
+  size_t nchild = children.size();
+  while (i < nchild)
+  {
+    size_t nargs = curType.getKind() == Kind::FUNCTION_TYPE
+                       ? curType.getNumChildren() - 1
+                       : nchild - i;
+    cc.resize(1);
+    for (size_t j = i, jend = std::min(i + nargs, nchild); j < jend; j++)
+    {
+      cc.push_back(children[j]);
+    }
+    Ctx cctx;
+    curType = getTypeAppInternal(curType.getValue(), cc, cctx, out);
+    if (curType.isNull())
+    {
+      return curType;
+    }
+    i += nargs;
+  }
+  return curType;
+}
+
+Expr TypeChecker::getTypeAppInternal(ExprValue* hdType,
+                                     ExprSpan children,
+                                     Ctx& ctx,
+                                     std::ostream* out)
+{
+  ExprValue* hd = children[0];
   if (hdType->getKind()!=Kind::FUNCTION_TYPE)
   {
     // non-function at head
@@ -362,7 +412,7 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
     }
     return d_null;
   }
-  std::vector<ExprValue*> hdtypes = hdType->d_children;
+  ExprSpan hdtypes = hdType->getChildren();
   std::vector<ExprValue*> ctypes;
   if (hdtypes.size() != children.size())
   {
@@ -426,7 +476,6 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
     Trace("type_checker") << "RUN type check " << Expr(hdType) << std::endl;
     return d_plugin->getType(hdType, ctypes, out);
   }
-  std::set<std::pair<ExprValue*, ExprValue*>> visited;
   Expr hdEval;
   for (size_t i=0, nchild=ctypes.size(); i<nchild; i++)
   {
@@ -436,14 +485,14 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
     // if the argument is (Quote t), we match on its argument,
     // which along with how ctypes[i] is the argument itself, has the effect
     // of an implicit upcast.
-    hdt = hdt->getKind() == Kind::QUOTE_TYPE ? hdt->d_children[0] : hdt;
+    hdt = hdt->getKind() == Kind::QUOTE_TYPE ? (*hdt)[0] : hdt;
     // must evaluate here
     if (hdt->isEvaluatable())
     {
-      hdEval = evaluate(hdt, ctx);
+      hdEval = evaluateCompiled(hdt, ctx);
       hdt = hdEval.getValue();
     }
-    if (!match(hdt, ctypes[i], ctx, visited))
+    if (!match(hdt, ctypes[i], ctx))
     {
       if (out)
       {
@@ -453,7 +502,7 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
           (*out) << "Unexpected child #" << i << std::endl;
           (*out) << "  Term: " << Expr(children[i + 1]) << std::endl;
           (*out) << "  Expected pattern: ";
-          hdto = hdto->d_children[0];
+          hdto = (*hdto)[0];
         }
         else
         {
@@ -474,25 +523,40 @@ Expr TypeChecker::getTypeAppInternal(std::vector<ExprValue*>& children,
     }
   }
   // evaluate in the matched context
-  return evaluate(hdtypes.back(), ctx);
+  ExprValue* ret = hdtypes.back();
+  if (hd->getKind() != Kind::PROOF_RULE || !d_opts.d_instCache)
+  {
+    return evaluateCompiled(ret, ctx);
+  }
+  // the conclusions of proof rules are cached, since the same rule is often
+  // applied in the same context
+  Expr conc;
+  bool cached = d_instCache.find(ret, ctx, conc);
+  if (!cached)
+  {
+    conc = evaluateCompiled(ret, ctx);
+    d_instCache.insert(ret, ctx, conc);
+  }
+  if (d_opts.d_stats)
+  {
+    RuleStat& rs = d_state.getStats().d_rstats[hd];
+    rs.d_instLookups++;
+    if (cached)
+    {
+      rs.d_instHits++;
+    }
+  }
+  return conc;
 }
 
 bool TypeChecker::match(ExprValue* a, ExprValue* b, Ctx& ctx)
 {
-  std::set<std::pair<ExprValue*, ExprValue*>> visited;
-  return match(a, b, ctx, visited);
-}
-
-bool TypeChecker::match(ExprValue* a,
-                        ExprValue* b,
-                        Ctx& ctx,
-                        std::set<std::pair<ExprValue*, ExprValue*>>& visited)
-{
-  std::set<std::pair<ExprValue*, ExprValue*>>::iterator it;
-  std::map<ExprValue*, ExprValue*>::iterator ctxIt;
-
-  std::vector<std::pair<ExprValue*, ExprValue*>> stack;
+  Ctx::iterator ctxIt;
+  // the scratch buffers are reused, since match does not call itself
+  std::vector<std::pair<ExprValue*, ExprValue*>>& stack = d_matchStack;
+  stack.clear();
   stack.emplace_back(a, b);
+  d_matchVisited.clear();
   std::pair<ExprValue*, ExprValue*> curr;
 
   while (!stack.empty())
@@ -504,13 +568,15 @@ bool TypeChecker::match(ExprValue* a,
       // holds trivially
       continue;
     }
-    it = visited.find(curr);
-    if (it != visited.end())
+    // A subterm of the pattern that has at most one reference has at most
+    // one parent, hence it is visited at most once per visit of its parent.
+    // We only remember the pairs for the other (possibly shared) subterms.
+    if (curr.first->d_rc > 1 && curr.first->getNumChildren() > 0
+        && !d_matchVisited.mark(curr.first, curr.second))
     {
       // already processed
       continue;
     }
-    visited.insert(curr);
     if (curr.first->getNumChildren() == 0)
     {
       // if the two subterms are not equal and the first one is a bound
@@ -542,11 +608,49 @@ bool TypeChecker::match(ExprValue* a,
     {
       // if the two subterms are not equal, make sure that their operators are
       // equal
-      if (curr.first->getNumChildren() != curr.second->getNumChildren()
-          || curr.first->getKind() != curr.second->getKind())
+      if (curr.first->getKind() != curr.second->getKind())
       {
         return false;
       }
+      if (curr.first->getNumChildren() != curr.second->getNumChildren())
+      {
+        if (!d_opts.d_naryApply || curr.first->getKind() != Kind::APPLY)
+        {
+          return false;
+        }
+        // n-ary applications of curried functions, e.g. (g x) matches
+        // (f a b) with g -> (f a), since the latter is ((f a) b).
+        ExprValue* s = curr.first;
+        ExprValue* l = curr.second;
+        bool swapped = s->getNumChildren() > l->getNumChildren();
+        if (swapped)
+        {
+          std::swap(s, l);
+        }
+        if (isNonCurriedSymbol((*s)[0]->getKind())
+            || isNonCurriedSymbol((*l)[0]->getKind()))
+        {
+          return false;
+        }
+        size_t ns = s->getNumChildren();
+        size_t nl = l->getNumChildren();
+        // the head of s matches the prefix of l, which is an application
+        // since l has more children than s
+        ExprSpan lchildren = l->getChildren();
+        std::vector<ExprValue*>& pchildren = d_matchChildren;
+        pchildren.assign(lchildren.begin(), lchildren.begin() + (nl - ns + 1));
+        ExprValue* lhd = d_state.mkExprInternal(Kind::APPLY, pchildren);
+        // lhd is not a subterm of either side, so ctx must keep it alive if
+        // it is bound
+        ctx.keepAlive(lhd);
+        stack.emplace_back(swapped ? lhd : (*s)[0], swapped ? (*s)[0] : lhd);
+        for (size_t i = 1; i < ns; i++)
+        {
+          ExprValue* lc = (*l)[nl - ns + i];
+          stack.emplace_back(swapped ? lc : (*s)[i], swapped ? (*s)[i] : lc);
+        }
+        continue;
+      }
       // recurse on children
       for (size_t i = 0, n = curr.first->getNumChildren(); i < n; ++i)
       {
@@ -561,13 +665,26 @@ bool TypeChecker::match(ExprValue* a,
 class EvFrame
 {
  public:
-  EvFrame(ExprValue* i, Ctx& ctx, ExprTrie* r) : d_init(i), d_ctx(ctx), d_result(r) {
+  EvFrame(ExprValue* i, Ctx ctx, size_t resultsStart)
+      : d_init(i), d_ctx(std::move(ctx)), d_resultsStart(resultsStart), d_bytes(0)
+  {
     if (d_init!=nullptr)
     {
       d_visit.push_back(d_init);
     }
   }
   ~EvFrame(){}
+  /** An estimate of the memory used by this frame, in bytes */
+  size_t getBytes() const
+  {
+    return sizeof(EvFrame)
+           + d_visited.size()
+                 * (sizeof(std::pair<ExprValue* const, Expr>)
+                    + 2 * sizeof(void*))
+           + d_visited.bucket_count() * sizeof(void*)
+           + d_visit.capacity() * sizeof(ExprValue*)
+           + d_ctx.size() * sizeof(Ctx::value_type);
+  }
   /** The initial value we are evaluating */
   ExprValue* d_init;
   /** The context it is being evaluated in */
@@ -576,13 +693,59 @@ class EvFrame
   std::unordered_map<ExprValue*, Expr> d_visited;
   /** The subterms to visit */
   std::vector<ExprValue*> d_visit;
-  /** An (optional) pointer of a trie of where to store the result */
-  ExprTrie * d_result;
+  /**
+   * The index of the first result of this frame in the pending results of
+   * evaluate. The results from this index onwards are the tries and program
+   * applications to store the result of this frame in, which may be more than
+   * one due to tail calls.
+   */
+  size_t d_resultsStart;
+  /** The memory used by this frame when it was suspended, in bytes */
+  size_t d_bytes;
 };
 
 Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
+{
+  Assert(e != nullptr);
+  // terms that are evaluated once are compiled only if they may apply
+  // programs, since otherwise compiling them costs more than traversing them
+  if (d_opts.d_evalVm && d_plugin == nullptr && e->isEvaluatable()
+      && (d_vm.hasCode(e) || Vm::hasCall(e)))
+  {
+    return d_vm.evaluate(e, ctx);
+  }
+  return evaluateInternal(e, ctx);
+}
+
+Expr TypeChecker::evaluateCompiled(ExprValue* e, Ctx& ctx)
+{
+  Assert(e != nullptr);
+  if (d_opts.d_evalVm && d_plugin == nullptr && e->isEvaluatable())
+  {
+    return d_vm.evaluate(e, ctx, true);
+  }
+  return evaluateInternal(e, ctx);
+}
+
+Expr TypeChecker::evaluateInternal(ExprValue* e, Ctx& ctx)
 {
   Assert (e!=nullptr);
+  // the term stays the same if it is not evaluatable and either it is ground,
+  // or the context is empty. This is common e.g. for return types.
+  if (!e->isEvaluatable() && (e->isGround() || ctx.empty()))
+  {
+    return Expr(e);
+  }
+  // terms that are not evaluatable are handled by substitution, unless they
+  // have a parameter that is replaced by a program or oracle
+  if (!e->isEvaluatable() && d_plugin == nullptr)
+  {
+    Expr ret = substitute(e, ctx);
+    if (!ret.isNull())
+    {
+      return ret;
+    }
+  }
   // A trie for all programs/oracles we have evaluated during this call.
   // This is required to ensure that programs that traverse terms recursively
   // preform a dag traversal.
@@ -594,9 +757,16 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
   std::vector<Expr> keepList;
   std::unordered_map<ExprValue*, Expr>::iterator it;
   Ctx::iterator itc;
+  // the application of a program we are evaluating, if memoized
+  Expr memoApp;
+  // the tries and program applications to store the results of frames in
+  std::vector<std::pair<ExprTrie*, Expr>> results;
+  // the memory used by the suspended frames, in bytes
+  size_t suspendedBytes = 0;
   // the evaluation stack
   std::vector<EvFrame> estack;
-  estack.emplace_back(e, ctx, nullptr);
+  estack.emplace_back(e, ctx, 0);
+  allocEvalVisited(estack.back().d_visited);
   Expr evaluated;
   ExprValue* cur;
   Kind ck;
@@ -640,10 +810,20 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
         //std::cout << "WARNING: unfilled variable " << cur << std::endl;
       }
       ck = cur->getKind();
-      std::vector<ExprValue*>& children = cur->d_children;
+      ExprSpan children = cur->getChildren();
       it = visited.find(cur);
       if (it == visited.end())
       {
+        if (!cur->isEvaluatable() && d_plugin == nullptr)
+        {
+          evaluated = substitute(cur, cctx);
+          if (!evaluated.isNull())
+          {
+            visited[cur] = evaluated;
+            visit.pop_back();
+            continue;
+          }
+        }
         // if it is compiled, we run its evaluation here
         if (d_plugin && d_plugin->hasEvaluation(cur))
         {
@@ -729,7 +909,7 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
                 Trace("type_checker_debug")
                     << "evaluated via cached evaluation" << std::endl;
               }
-              else
+              else if (!findProgramMemo(cchildren, evaluated, memoApp))
               {
                 Ctx newCtx;
                 // see if we evaluate
@@ -741,14 +921,38 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
                   // push a context
                   // store the base evaluation (if applicable)
                   et->d_data = evaluated.getValue();
+                  insertProgramMemo(memoApp, evaluated);
+                }
+                else if (visit.size() == 1)
+                {
+                  // If this application is the term of the current frame, it
+                  // is a tail call, and its body is evaluated in this frame.
+                  // We do not evaluate it further on this iteration.
+                  results.emplace_back(et, memoApp);
+                  evf.d_init = evaluated.getValue();
+                  evf.d_ctx = std::move(newCtx);
+                  visited.clear();
+                  visit.back() = evf.d_init;
+                  canEvaluate = false;
                 }
                 else
                 {
                   // otherwise push an evaluation scope
                   newContext = true;
-                  estack.emplace_back(evaluated.getValue(), newCtx, et);
+                  evf.d_bytes = evf.getBytes();
+                  suspendedBytes += evf.d_bytes;
+                  results.emplace_back(et, memoApp);
+                  estack.emplace_back(
+                      evaluated.getValue(), std::move(newCtx), results.size() - 1);
+                  allocEvalVisited(estack.back().d_visited);
                 }
               }
+              else
+              {
+                et->d_data = evaluated.getValue();
+                Trace("type_checker_debug")
+                    << "evaluated via memoized evaluation" << std::endl;
+              }
             }
           }
             break;
@@ -765,6 +969,14 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
               if (cchildren[index] == nullptr)
               {
                 canEvaluate = false;
+                if (visit.size() == 1)
+                {
+                  // if this is the term of the current frame, its result is
+                  // the result of the relevant child, which is evaluated in
+                  // its place
+                  evf.d_init = children[index];
+                  visit.pop_back();
+                }
                 // evaluate the child if not yet done so
                 visit.push_back(children[index]);
               }
@@ -847,21 +1059,31 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
       evaluated = evf.d_visited[init];
       Trace("type_checker") << "EVALUATE " << Expr(init) << ", "
                             << evf.d_ctx << " = " << evaluated << std::endl;
-      if (evf.d_result!=nullptr)
+      Stats& stats = d_state.getStats();
+      stats.d_evalMaxDepth = std::max(stats.d_evalMaxDepth, estack.size());
+      stats.d_evalMaxFrameBytes =
+          std::max(stats.d_evalMaxFrameBytes, suspendedBytes + evf.getBytes());
+      for (size_t i = evf.d_resultsStart, nresults = results.size();
+           i < nresults;
+           i++)
       {
         ExprValue * ev = evaluated.getValue();
         if (keep.insert(ev).second)
         {
           keepList.emplace_back(ev);
         }
-        evf.d_result->d_data = ev;
+        results[i].first->d_data = ev;
+        insertProgramMemo(results[i].second, evaluated);
       }
+      results.resize(evf.d_resultsStart);
       // pop the evaluation context
+      freeEvalVisited(evf.d_visited);
       estack.pop_back();
       // carry to lower context
       if (!estack.empty())
       {
         EvFrame& evp = estack.back();
+        suspendedBytes -= evp.d_bytes;
         Assert (!evp.d_visit.empty());
         evp.d_visited[evp.d_visit.back()] = evaluated;
         evp.d_visit.pop_back();
@@ -875,6 +1097,148 @@ Expr TypeChecker::evaluate(ExprValue* e, Ctx& ctx)
   return evaluated;
 }
 
+void TypeChecker::allocEvalVisited(
+    std::unordered_map<ExprValue*, Expr>& visited)
+{
+  if (!d_evalVisitedPool.empty())
+  {
+    visited.swap(d_evalVisitedPool.back());
+    d_evalVisitedPool.pop_back();
+  }
+}
+
+void TypeChecker::freeEvalVisited(std::unordered_map<ExprValue*, Expr>& visited)
+{
+  // caches with many buckets are not recycled, since clearing them is linear
+  // in their number of buckets
+  if (visited.bucket_count() > s_evalVisitedMaxBuckets)
+  {
+    return;
+  }
+  visited.clear();
+  d_evalVisitedPool.emplace_back(std::move(visited));
+}
+
+bool TypeChecker::findProgramMemo(const std::vector<ExprValue*>& children,
+                                  Expr& result,
+                                  Expr& app)
+{
+  app = d_null;
+  if (!d_opts.d_progMemo || children[0]->getKind() != Kind::PROGRAM_CONST
+      || !isGround(children))
+  {
+    return false;
+  }
+  app = Expr(d_state.mkExprInternal(Kind::APPLY, children));
+  Stats& stats = d_state.getStats();
+  if (d_progMemo.find(app.getValue(), result))
+  {
+    stats.d_progMemoHits++;
+    return true;
+  }
+  stats.d_progMemoMisses++;
+  return false;
+}
+
+void TypeChecker::insertProgramMemo(const Expr& app, const Expr& result)
+{
+  if (app.isNull())
+  {
+    return;
+  }
+  d_state.getStats().d_progMemoEvictions +=
+      d_progMemo.insert(app, result, d_opts.d_progMemoSize);
+}
+
+Expr TypeChecker::substitute(ExprValue* e, const Ctx& ctx)
+{
+  Assert(!e->isEvaluatable());
+  // the scratch buffers are reused, since substitute does not call itself
+  std::vector<std::pair<ExprValue*, bool>>& visit = d_substVisit;
+  std::vector<Expr>& results = d_substResults;
+  std::unordered_map<const ExprValue*, Expr>& cache = d_substCache;
+  std::vector<ExprValue*>& cchildren = d_substChildren;
+  visit.clear();
+  results.clear();
+  if (!cache.empty())
+  {
+    cache.clear();
+  }
+  visit.emplace_back(e, false);
+  std::unordered_map<const ExprValue*, Expr>::iterator it;
+  Ctx::const_iterator itc;
+  while (!visit.empty())
+  {
+    std::pair<ExprValue*, bool>& cur = visit.back();
+    ExprValue* cv = cur.first;
+    if (cv->isGround())
+    {
+      results.emplace_back(cv);
+      visit.pop_back();
+      continue;
+    }
+    if (cv->getNumChildren() == 0)
+    {
+      itc = ctx.find(cv);
+      results.emplace_back(itc == ctx.end() ? cv : itc->second);
+      visit.pop_back();
+      continue;
+    }
+    // as in match, only subterms with more than one reference may be
+    // visited more than once, hence only they are cached
+    bool shared = cv->d_rc > 1;
+    if (!cur.second)
+    {
+      if (shared)
+      {
+        it = cache.find(cv);
+        if (it != cache.end())
+        {
+          results.push_back(it->second);
+          visit.pop_back();
+          continue;
+        }
+      }
+      cur.second = true;
+      // visit the children in reverse, so that their results are in order
+      ExprSpan children = cv->getChildren();
+      for (size_t i = children.size(); i > 0; i--)
+      {
+        visit.emplace_back(children[i - 1], false);
+      }
+      continue;
+    }
+    visit.pop_back();
+    size_t nchildren = cv->getNumChildren();
+    size_t start = results.size() - nchildren;
+    cchildren.clear();
+    bool cchanged = false;
+    for (size_t i = 0; i < nchildren; i++)
+    {
+      ExprValue* cc = results[start + i].getValue();
+      cchildren.push_back(cc);
+      cchanged = cchanged || cc != (*cv)[i];
+    }
+    Kind k = cv->getKind();
+    if ((k == Kind::APPLY || k == Kind::APPLY_OPAQUE)
+        && (cchildren[0]->getKind() == Kind::PROGRAM_CONST
+            || cchildren[0]->getKind() == Kind::ORACLE))
+    {
+      // the result is evaluatable, which requires the full evaluator
+      return d_null;
+    }
+    Expr ret(cchanged ? d_state.mkExprInternal(k, cchildren) : cv);
+    results.resize(start);
+    if (shared)
+    {
+      cache[cv] = ret;
+    }
+    results.emplace_back(ret);
+  }
+  Assert(results.size() == 1);
+  return results.back();
+}
+
 Expr TypeChecker::evaluateProgram(
     const std::vector<ExprValue*>& children, Ctx& newCtx)
 {
@@ -917,40 +1281,59 @@ Expr TypeChecker::evaluateProgramInternal(
       return d_plugin->evaluateProgram(hd, children, newCtx);
     }
     size_t nargs = children.size();
-    Expr prog = d_state.getProgram(hd);
-    Assert (!prog.isNull());
-    if (!prog.isNull())
+    const ProgramIndex* pindex = d_state.getProgramIndex(hd);
+    // the program may be forward declared and not yet defined, in which case
+    // the application does not evaluate
+    if (pindex!=nullptr)
     {
       Trace("type_checker") << "INTERPRET program " << children << std::endl;
-      // otherwise, evaluate
-      for (size_t i = 0, nchildren = prog.getNumChildren(); i < nchildren;
-           i++)
+      Stats& stats = d_state.getStats();
+      stats.d_programCalls++;
+      const Expr& prog = pindex->getProgram();
+      if (nargs != pindex->getArity())
       {
-        const Expr& c = prog[i];
-        newCtx.clear();
-        ExprValue* hd = c[0].getValue();
-        std::vector<ExprValue*>& hchildren = hd->d_children;
-        if (nargs != hchildren.size())
-        {
-          // TODO: catch this during weak type checking of program bodies
-          Warning() << "*** Bad number of arguments provided in function call to " << hd << std::endl;
-          Warning() << "  Arguments: " << children << std::endl;
-          return d_null;
-        }
-        bool matchSuccess = true;
-        for (size_t i=1; i<nargs; i++)
+        // TODO: catch this during weak type checking of program bodies
+        Warning() << "*** Bad number of arguments provided in function call to " << prog[0][0] << std::endl;
+        Warning() << "  Arguments: " << children << std::endl;
+        return d_null;
+      }
+      // only the cases in the index that are candidates are matched, in order
+      std::vector<uint64_t>& cands = d_progCands;
+      bool hasCands = pindex->getCandidates(children, cands);
+      for (size_t w = 0, nwords = cands.size(); hasCands && w < nwords; w++)
+      {
+        uint64_t bits = cands[w];
+        while (bits != 0)
         {
-          if (!match(hchildren[i], children[i], newCtx))
+          size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+          bits &= bits - 1;
+          const Expr& c = prog[i];
+          newCtx.clear();
+          ExprValue* hd = c[0].getValue();
+          ExprSpan hchildren = hd->getChildren();
+          if (nargs != hchildren.size())
           {
-            matchSuccess = false;
-            break;
+            // TODO: catch this during weak type checking of program bodies
+            Warning() << "*** Bad number of arguments provided in function call to " << hd << std::endl;
+            Warning() << "  Arguments: " << children << std::endl;
+            return d_null;
+          }
+          stats.d_programCasesTried++;
+          bool matchSuccess = true;
+          for (size_t j=1; j<nargs; j++)
+          {
+            if (!match(hchildren[j], children[j], newCtx))
+            {
+              matchSuccess = false;
+              break;
+            }
+          }
+          if (matchSuccess)
+          {
+            Trace("type_checker")
+                << "...matches " << Expr(hd) << ", ctx = " << newCtx << std::endl;
+            return c[1];
           }
-        }
-        if (matchSuccess)
-        {
-          Trace("type_checker")
-              << "...matches " << Expr(hd) << ", ctx = " << newCtx << std::endl;
-          return c[1];
         }
       }
       Trace("type_checker") << "...failed to match." << std::endl;
@@ -1027,44 +1410,18 @@ Expr TypeChecker::evaluateLiteralOp(Kind k,
 }
 
 /**
- * Get nary children, gets a list of children from op-application e
- * up to maxChildren (0 means no limit), stores them in children.
+ * Returns true if tail, which is the term after the last element of the
+ * op-application orig, is the nil terminator nil.
  */
-ExprValue* getNAryChildren(ExprValue* e,
-                           ExprValue* op,
-                           ExprValue* checkNil,
-                           std::vector<ExprValue*>& children,
-                           bool isLeft,
-                           size_t maxChildren=0)
+bool isListTail(ExprValue* tail, ExprValue* nil, ExprValue* orig)
 {
-  ExprValue* orig = e;
-  while (e->getKind()==Kind::APPLY)
+  if (tail != nil)
   {
-    ExprValue* cop = (*e)[0];
-    if (cop->getKind()!=Kind::APPLY)
-    {
-      break;
-    }
-    if ((*cop)[0] != op)
-    {
-      break;
-    }
-    // push back the element
-    children.push_back(isLeft ? (*e)[1] : (*cop)[1]);
-    // traverse to tail
-    e = isLeft ? (*cop)[1] : (*e)[1];
-    if (children.size()==maxChildren)
-    {
-      return e;
-    }
-  }
-  // must be equal to the nil term, if provided
-  if (checkNil!=nullptr && e!=checkNil)
-  {
-    Warning() << "...expected associative application to end in " << Expr(checkNil) << ", got " << Expr(orig) << std::endl;
-    return nullptr;
+    Warning() << "...expected associative application to end in "
+              << Expr(nil) << ", got " << Expr(orig) << std::endl;
+    return false;
   }
-  return e;
+  return true;
 }
 
 Expr TypeChecker::evaluateLiteralOpInternal(
@@ -1315,7 +1672,8 @@ Expr TypeChecker::evaluateLiteralOpInternal(
   }
   ExprValue * nil = nilExpr.getValue();
   ExprValue* ret;
-  std::vector<ExprValue*> hargs;
+  ListCache& lc = d_state.d_listCache;
+  size_t length;
   switch (k)
   {
     case Kind::EVAL_NIL:
@@ -1330,23 +1688,38 @@ Expr TypeChecker::evaluateLiteralOpInternal(
       size_t tailIndex = (isLeft ? 1 : 2);
       size_t headIndex = (isLeft ? 2 : 1);
       ret = args[isConcat ? tailIndex : 2];
-      std::vector<ExprValue*> targs;
-      ExprValue* b = getNAryChildren(ret, op, nil, targs, isLeft);
-      if (b==nullptr)
+      if (!isListTail(lc.getTail(ret, op, isLeft, length), nil, ret))
       {
         Trace("type_checker") << "...tail not in list form, nil is " << nilExpr << std::endl;
         // tail is not in list form
         return d_null;
       }
+      std::vector<ExprValue*> hargs;
       if (k==Kind::EVAL_CONS)
       {
         hargs.push_back(args[1]);
       }
       else
       {
-        // extract all children of the head
-        ExprValue* a = getNAryChildren(args[headIndex], op, nil, hargs, isLeft);
-        if (a==nullptr)
+        // extract all children of the head, which may already be flattened
+        ExprValue* a = args[headIndex];
+        ListView* hv = lc.findView(a, op);
+        if (hv != nullptr)
+        {
+          hargs = hv->d_elements;
+          a = hv->d_tail;
+        }
+        else
+        {
+          ExprValue* elem;
+          ExprValue* next;
+          while ((next = ListCache::getNext(a, op, isLeft, elem)) != nullptr)
+          {
+            hargs.push_back(elem);
+            a = next;
+          }
+        }
+        if (!isListTail(a, nil, args[headIndex]))
         {
           Trace("type_checker") << "...head not in list form" << std::endl;
           // head is not in list form
@@ -1371,13 +1744,12 @@ Expr TypeChecker::evaluateLiteralOpInternal(
       break;
     case Kind::EVAL_LIST_LENGTH:
     {
-      ExprValue* a = getNAryChildren(args[1], op, nil, hargs, isLeft);
-      if (a==nullptr)
+      if (!isListTail(lc.getTail(args[1], op, isLeft, length), nil, args[1]))
       {
         Trace("type_checker") << "...head not in list form" << std::endl;
         return d_null;
       }
-      Literal lret = Literal(Integer(hargs.size()));
+      Literal lret = Literal(Integer(length));
       return Expr(d_state.mkLiteralInternal(lret));
     }
       break;
@@ -1394,25 +1766,27 @@ Expr TypeChecker::evaluateLiteralOpInternal(
         return d_null;
       }
       size_t i = index.toUnsignedInt();
-      // extract up to i+1 children
-      getNAryChildren(args[1], op, nil, hargs, isLeft, i+1);
-      if (hargs.size()==i+1)
+      // the i^th child is taken from the flattened list, which is computed
+      // on the first use
+      const ListView& v = lc.getView(args[1], op, isLeft);
+      if (i < v.d_elements.size())
       {
-        return Expr(hargs.back());
+        return Expr(v.d_elements[i]);
       }
+      isListTail(v.d_tail, nil, args[1]);
       return d_null;
     }
       break;
     case Kind::EVAL_LIST_FIND:
     {
-      ExprValue* a = getNAryChildren(args[1], op, nil, hargs, isLeft);
-      if (a==nullptr)
+      ListView& v = lc.getView(args[1], op, isLeft);
+      if (!isListTail(v.d_tail, nil, args[1]))
       {
         Trace("type_checker") << "...head not in list form" << std::endl;
         return d_null;
       }
-      std::vector<ExprValue*>::iterator it = std::find(hargs.begin(), hargs.end(), args[2]);
-      if (it==hargs.end())
+      size_t iret = v.find(args[2]);
+      if (iret == v.d_elements.size())
       {
         if (d_negOne.isNull())
         {
@@ -1421,7 +1795,6 @@ Expr TypeChecker::evaluateLiteralOpInternal(
         }
         return d_negOne;
       }
-      size_t iret = std::distance(hargs.begin(), it);
       Literal lret = Literal(Integer(iret));
       return Expr(d_state.mkLiteralInternal(lret));
     }
@@ -1433,7 +1806,7 @@ Expr TypeChecker::evaluateLiteralOpInternal(
 }
 
 ExprValue* TypeChecker::getLiteralOpType(Kind k,
-                                         std::vector<ExprValue*>& children,
+                                         ExprSpan children,
                                          std::vector<ExprValue*>& childTypes,
                                          std::ostream* out)
 {
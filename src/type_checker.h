@@ -10,10 +10,14 @@
 #define TYPE_CHECKER_H
 
 #include <map>
-#include <set>
+#include <unordered_map>
 #include "expr.h"
 #include "expr_trie.h"
 #include "expr_info.h"
+#include "inst_cache.h"
+#include "pair_marker.h"
+#include "program_memo.h"
+#include "vm.h"
 
 namespace ethos {
 
@@ -28,6 +32,7 @@ class Plugin;
 class TypeChecker
 {
   friend class State;
+  friend class Vm;
 
  public:
   TypeChecker(State& s, Options& opts);
@@ -50,7 +55,8 @@ class TypeChecker
   /** Set type rule for literal kind k to t */
   void setLiteralTypeRule(Kind k, const Expr& t);
   /**
-   * Evaluate the expression e in the given context.
+   * Evaluate the expression e in the given context. This uses the bytecode
+   * interpreter if the option eval-vm is enabled.
    */
   Expr evaluate(ExprValue* e, Ctx& ctx);
   /**
@@ -81,15 +87,51 @@ class TypeChecker
    * that when applied to b gives a. The substitution
    */
   bool match(ExprValue* a, ExprValue* b, Ctx& ctx);
-  /** Same as above, but takes a cache of pairs we have already visited */
-  bool match(ExprValue* a,
-             ExprValue* b,
-             Ctx& ctx,
-             std::set<std::pair<ExprValue*, ExprValue*>>& visited);
   /** */
-  Expr getTypeAppInternal(std::vector<ExprValue*>& children,
+  Expr getTypeAppInternal(ExprSpan children,
                           Ctx& ctx,
                           std::ostream* out = nullptr);
+  /**
+   * Same as above, where hdType is the type of children[0]. This requires
+   * that hdType takes exactly children.size()-1 arguments.
+   */
+  Expr getTypeAppInternal(ExprValue* hdType,
+                          ExprSpan children,
+                          Ctx& ctx,
+                          std::ostream* out);
+  /**
+   * Get the type of the n-ary application (APPLY children) of a curried
+   * function, which is typed as (...((f a1) a2) ... an).
+   */
+  Expr getTypeNaryAppInternal(ExprSpan children, std::ostream* out);
+  /**
+   * If memoization of programs is enabled and children is an application of
+   * a program to ground arguments, set app to that application. Returns true
+   * if the result of app is memoized, in which case result is set to it.
+   */
+  bool findProgramMemo(const std::vector<ExprValue*>& children,
+                       Expr& result,
+                       Expr& app);
+  /** Evaluate the expression e in the given context by the tree interpreter */
+  Expr evaluateInternal(ExprValue* e, Ctx& ctx);
+  /**
+   * Evaluate e, which is part of the type of a symbol, in the given context.
+   * If the option eval-vm is enabled, the code for e is kept.
+   */
+  Expr evaluateCompiled(ExprValue* e, Ctx& ctx);
+  /** Get a visited cache for a frame of evaluate from the pool */
+  void allocEvalVisited(std::unordered_map<ExprValue*, Expr>& visited);
+  /** Return the visited cache of a frame of evaluate to the pool */
+  void freeEvalVisited(std::unordered_map<ExprValue*, Expr>& visited);
+  /** Memoize the result of app, if app is not null */
+  void insertProgramMemo(const Expr& app, const Expr& result);
+  /**
+   * Substitute ctx into e, which is not evaluatable. This returns the same
+   * result as evaluate, or null if a parameter in e is replaced by a program
+   * or oracle that is applied to arguments, in which case the result may
+   * need to be evaluated.
+   */
+  Expr substitute(ExprValue* e, const Ctx& ctx);
   /** Are all args ground? */
   static bool isGround(const std::vector<ExprValue*>& args);
   /** Maybe evaluate */
@@ -103,7 +145,7 @@ class TypeChecker
   Expr evaluateLiteralOpInternal(Kind k, const std::vector<ExprValue*>& args);
   /** Type check */
   ExprValue* getLiteralOpType(Kind k,
-                              std::vector<ExprValue*>& children,
+                              ExprSpan children,
                               std::vector<ExprValue*>& childTypes,
                               std::ostream* out);
   /** Get the nil terminator */
@@ -116,8 +158,36 @@ class TypeChecker
                                      Expr& nil);
   /** The state */
   State& d_state;
+  /** The options */
+  Options& d_opts;
   /** Plugin of the state */
   Plugin * d_plugin;
+  /** The stack of pairs to match, used in match */
+  std::vector<std::pair<ExprValue*, ExprValue*>> d_matchStack;
+  /** The pairs already matched, used in match */
+  PairMarker d_matchVisited;
+  /** The children of the head of an n-ary application, used in match */
+  std::vector<ExprValue*> d_matchChildren;
+  /** The stack of subterms to visit, used in substitute */
+  std::vector<std::pair<ExprValue*, bool>> d_substVisit;
+  /** The stack of results of subterms, used in substitute */
+  std::vector<Expr> d_substResults;
+  /** The results of shared subterms, used in substitute */
+  std::unordered_map<const ExprValue*, Expr> d_substCache;
+  /** The children of the current subterm, used in substitute */
+  std::vector<ExprValue*> d_substChildren;
+  /** The visited caches of frames of evaluate that are not in use */
+  std::vector<std::unordered_map<ExprValue*, Expr>> d_evalVisitedPool;
+  /** The maximum number of buckets of caches that are returned to the pool */
+  static const size_t s_evalVisitedMaxBuckets = 1024;
+  /** Cache of the conclusions of proof rules */
+  InstCache d_instCache;
+  /** Memo table for programs applied to ground arguments */
+  ProgramMemo d_progMemo;
+  /** The bytecode interpreter */
+  Vm d_vm;
+  /** The candidate cases of the program being evaluated */
+  std::vector<uint64_t> d_progCands;
   /** Mapping literal kinds to type rules */
   std::map<Kind, Expr> d_literalTypeRules;
   /** The null expression */
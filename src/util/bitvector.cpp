@@ -8,34 +8,209 @@
  ******************************************************************************/
 #include "util/bitvector.h"
 
+#include <limits>
+
 #include "base/check.h"
 
 namespace ethos {
 
-BitVector::BitVector(const std::string& num, uint32_t base)
+BitVector::BitVector(unsigned size, const Integer& val) : d_size(size), d_word(0)
+{
+  setValue(val);
+}
+
+BitVector::BitVector(unsigned size) : d_size(size), d_word(0)
+{
+  if (d_size > 64)
+  {
+    d_big.reset(new Integer());
+  }
+}
+
+BitVector::BitVector(unsigned size, uint32_t z) : d_size(size), d_word(0)
+{
+  if (d_size <= 64)
+  {
+    d_word = z & mask(d_size);
+    return;
+  }
+  d_big.reset(new Integer(static_cast<int64_t>(z)));
+}
+
+BitVector::BitVector(unsigned size, uint64_t z) : d_size(size), d_word(0)
+{
+  if (d_size <= 64)
+  {
+    d_word = z & mask(d_size);
+    return;
+  }
+  d_big.reset(new Integer(wordToInteger(z)));
+}
+
+BitVector::BitVector(unsigned size, const BitVector& q)
+    : d_size(size), d_word(0)
+{
+  if (q.isSmall())
+  {
+    if (d_size <= 64)
+    {
+      d_word = q.d_word & mask(d_size);
+      return;
+    }
+    d_big.reset(new Integer(wordToInteger(q.d_word)));
+    return;
+  }
+  setValue(*q.d_big);
+}
+
+BitVector::BitVector(const std::string& num, uint32_t base) : d_word(0)
 {
   Assert(base == 2 || base == 10 || base == 16);
   Assert(num[0] != '-');
-  d_value = Integer(num, base);
-  Assert(d_value.sgn()>=0);
   // Compute the length, *without* any negative sign.
   switch (base)
   {
-    case 10: d_size = d_value.length(); break;
+    case 10: break;
     case 16: d_size = num.size() * 4; break;
     default: d_size = num.size();
   }
+  if (base != 10 && d_size <= 64)
+  {
+    // parse the digits directly into the word
+    unsigned shift = base == 16 ? 4 : 1;
+    for (char c : num)
+    {
+      uint64_t digit;
+      if (c >= '0' && c <= '9')
+      {
+        digit = static_cast<uint64_t>(c - '0');
+      }
+      else if (c >= 'a' && c <= 'f')
+      {
+        digit = static_cast<uint64_t>(c - 'a' + 10);
+      }
+      else
+      {
+        Assert(c >= 'A' && c <= 'F');
+        digit = static_cast<uint64_t>(c - 'A' + 10);
+      }
+      Assert(digit < base);
+      d_word = (d_word << shift) | digit;
+    }
+    return;
+  }
+  Integer val(num, base);
+  Assert(val.sgn() >= 0);
+  if (base == 10)
+  {
+    d_size = val.length();
+  }
+  setValue(val);
+}
+
+BitVector::BitVector(const BitVector& x) : d_size(x.d_size), d_word(x.d_word)
+{
+  if (x.d_big != nullptr)
+  {
+    d_big.reset(new Integer(*x.d_big));
+  }
+}
+
+BitVector& BitVector::operator=(const BitVector& x)
+{
+  if (this == &x) return *this;
+  d_size = x.d_size;
+  d_word = x.d_word;
+  if (x.d_big == nullptr)
+  {
+    d_big.reset();
+  }
+  else
+  {
+    d_big.reset(new Integer(*x.d_big));
+  }
+  return *this;
+}
+
+Integer BitVector::wordToInteger(uint64_t w)
+{
+  if (w <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+  {
+    return Integer(static_cast<int64_t>(w));
+  }
+  Integer hi(static_cast<int64_t>(w >> 32));
+  return hi.multiplyByPow2(32)
+         + Integer(static_cast<int64_t>(w & 0xffffffff));
+}
+
+uint64_t BitVector::integerToWord(const Integer& val)
+{
+  Assert(val.sgn() >= 0);
+  if (val.isSmall())
+  {
+    return static_cast<uint64_t>(val.getSmall());
+  }
+  uint64_t hi = static_cast<uint64_t>(val.extractBitRange(32, 32).getSmall());
+  uint64_t lo = static_cast<uint64_t>(val.extractBitRange(32, 0).getSmall());
+  return (hi << 32) | lo;
+}
+
+void BitVector::setValue(const Integer& val)
+{
+  if (d_size > 64)
+  {
+    d_word = 0;
+    d_big.reset(new Integer(val.modByPow2(d_size)));
+    return;
+  }
+  d_big.reset();
+  if (val.isSmall())
+  {
+    // two's complement conversion is the value modulo 2^64
+    d_word = static_cast<uint64_t>(val.getSmall()) & mask(d_size);
+    return;
+  }
+  d_word = integerToWord(val.modByPow2(d_size));
 }
 
 unsigned BitVector::getSize() const { return d_size; }
 
-const Integer& BitVector::getValue() const { return d_value; }
+Integer BitVector::getValue() const
+{
+  return d_big == nullptr ? wordToInteger(d_word) : *d_big;
+}
 
-Integer BitVector::toInteger() const { return d_value; }
+Integer BitVector::toInteger() const { return getValue(); }
 
 std::string BitVector::toString(unsigned int base) const
 {
-  std::string str = d_value.toString(base);
+  if (d_size==0)
+  {
+    // special case, if size is zero, then print nothing
+    return "";
+  }
+  if (d_big == nullptr && (base == 2 || base == 16))
+  {
+    std::string str;
+    if (base == 2)
+    {
+      str.resize(d_size);
+      for (unsigned i = 0; i < d_size; i++)
+      {
+        str[d_size - 1 - i] = ((d_word >> i) & 1) ? '1' : '0';
+      }
+      return str;
+    }
+    static const char* digits = "0123456789abcdef";
+    uint64_t w = d_word;
+    do
+    {
+      str.push_back(digits[w & 0xf]);
+      w >>= 4;
+    } while (w != 0);
+    return std::string(str.rbegin(), str.rend());
+  }
+  std::string str = getValue().toString(base);
   if (base == 2 && d_size > str.size())
   {
     std::string zeroes;
@@ -45,17 +220,17 @@ std::string BitVector::toString(unsigned int base) const
     }
     return zeroes + str;
   }
-  else if (d_size==0)
-  {
-    // special case, if size is zero, then print nothing
-    return "";
-  }
   return str;
 }
 
 size_t BitVector::hash() const
 {
-  return std::hash<size_t>()(d_value.hash()) ^ std::hash<size_t>()(d_size);
+  if (d_big == nullptr)
+  {
+    uint64_t h = (d_word ^ d_size) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+  return std::hash<size_t>()(d_big->hash()) ^ std::hash<size_t>()(d_size);
 }
 
 /* -----------------------------------------------------------------------
@@ -66,16 +241,36 @@ size_t BitVector::hash() const
 
 BitVector BitVector::concat(const BitVector& other) const
 {
-  return BitVector(d_size + other.d_size,
-                   (d_value.multiplyByPow2(other.d_size)) + other.d_value);
+  unsigned size = d_size + other.d_size;
+  if (size <= 64)
+  {
+    uint64_t hi = other.d_size == 64 ? 0 : (d_word << other.d_size);
+    return BitVector(size, hi | other.d_word);
+  }
+  return BitVector(size,
+                   (getValue().multiplyByPow2(other.d_size))
+                       + other.getValue());
 }
 
 BitVector BitVector::extract(unsigned high, unsigned low) const
 {
   Assert(high < d_size);
   Assert(low <= high);
-  return BitVector(high - low + 1,
-                   d_value.extractBitRange(high - low + 1, low));
+  unsigned size = high - low + 1;
+  if (d_big == nullptr)
+  {
+    return BitVector(size, d_word >> low);
+  }
+  return BitVector(size, d_big->extractBitRange(size, low));
+}
+
+bool BitVector::unsignedGreaterThan(const BitVector& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return d_word > y.d_word;
+  }
+  return getValue() > y.getValue();
 }
 
 /* (Dis)Equality --------------------------------------------------------- */
@@ -83,6 +278,10 @@ BitVector BitVector::extract(unsigned high, unsigned low) const
 bool operator==(const BitVector& a, const BitVector& b)
 {
   if (a.getSize() != b.getSize()) return false;
+  if (a.isSmall())
+  {
+    return a.getWord() == b.getWord();
+  }
   return a.getValue() == b.getValue();
 }
 
@@ -91,23 +290,39 @@ bool operator==(const BitVector& a, const BitVector& b)
 BitVector operator^(const BitVector& a, const BitVector& b)
 {
   Assert(a.getSize() == b.getSize());
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), a.getWord() ^ b.getWord());
+  }
   return BitVector(a.getSize(), a.getValue().bitwiseXor(b.getValue()));
 }
 
 BitVector operator|(const BitVector& a, const BitVector& b)
 {
   Assert(a.getSize() == b.getSize());
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), a.getWord() | b.getWord());
+  }
   return BitVector(a.getSize(), a.getValue().bitwiseOr(b.getValue()));
 }
 
 BitVector operator&(const BitVector& a, const BitVector& b)
 {
   Assert(a.getSize() == b.getSize());
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), a.getWord() & b.getWord());
+  }
   return BitVector(a.getSize(), a.getValue().bitwiseAnd(b.getValue()));
 }
 
 BitVector operator~(const BitVector& a)
 {
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), ~a.getWord());
+  }
   return BitVector(a.getSize(), a.getValue().bitwiseNot());
 }
 
@@ -116,12 +331,21 @@ BitVector operator~(const BitVector& a)
 BitVector operator+(const BitVector& a, const BitVector& b)
 {
   Assert(a.getSize() == b.getSize());
+  if (a.isSmall())
+  {
+    // unsigned arithmetic wraps modulo 2^64
+    return BitVector(a.getSize(), a.getWord() + b.getWord());
+  }
   Integer sum = a.getValue() + b.getValue();
   return BitVector(a.getSize(), sum);
 }
 
 BitVector operator-(const BitVector& a)
 {
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), uint64_t(0) - a.getWord());
+  }
   BitVector one(a.getSize(), Integer(1));
   return ~a + one;
 }
@@ -129,6 +353,10 @@ BitVector operator-(const BitVector& a)
 BitVector operator*(const BitVector& a, const BitVector& b)
 {
   Assert(a.getSize() == b.getSize());
+  if (a.isSmall())
+  {
+    return BitVector(a.getSize(), a.getWord() * b.getWord());
+  }
   Integer prod = a.getValue() * b.getValue();
   return BitVector(a.getSize(), prod);
 }
@@ -136,26 +364,36 @@ BitVector operator*(const BitVector& a, const BitVector& b)
 BitVector BitVector::unsignedDivTotal(const BitVector& y) const
 {
   Assert(d_size == y.d_size);
+  if (d_big == nullptr)
+  {
+    /* d_word / 0 = -1 = 2^d_size - 1 */
+    return BitVector(d_size,
+                     y.d_word == 0 ? ~uint64_t(0) : d_word / y.d_word);
+  }
   /* d_value / 0 = -1 = 2^d_size - 1 */
-  if (y.d_value.sgn()==0)
+  if (y.d_big->sgn()==0)
   {
     return BitVector(d_size, Integer(1).oneExtend(1, d_size - 1));
   }
-  Assert(d_value.sgn() >= 0);
-  Assert(y.d_value.sgn() > 0);
-  return BitVector(d_size, d_value.floorDivideQuotient(y.d_value));
+  Assert(d_big->sgn() >= 0);
+  Assert(y.d_big->sgn() > 0);
+  return BitVector(d_size, d_big->floorDivideQuotient(*y.d_big));
 }
 
 BitVector BitVector::unsignedRemTotal(const BitVector& y) const
 {
   Assert(d_size == y.d_size);
-  if (y.d_value.sgn()==0)
+  if (d_big == nullptr)
+  {
+    return BitVector(d_size, y.d_word == 0 ? d_word : d_word % y.d_word);
+  }
+  if (y.d_big->sgn()==0)
   {
-    return BitVector(d_size, d_value);
+    return BitVector(d_size, *d_big);
   }
-  Assert(d_value.sgn() >= 0);
-  Assert(y.d_value.sgn() > 0);
-  return BitVector(d_size, d_value.floorDivideRemainder(y.d_value));
+  Assert(d_big->sgn() >= 0);
+  Assert(y.d_big->sgn() > 0);
+  return BitVector(d_size, d_big->floorDivideRemainder(*y.d_big));
 }
 
 }  // namespace cvc5::internal
@@ -12,20 +12,26 @@
 
 #include <iosfwd>
 #include <iostream>
+#include <memory>
 
 #include "util/integer.h"
 
 namespace ethos {
 
+/**
+ * A fixed-width bit-vector.
+ *
+ * Bit-vectors whose width is at most 64 are stored in a single machine word
+ * and all operations on them are performed on that word. Wider bit-vectors
+ * are stored as an Integer.
+ */
 class BitVector
 {
  public:
-  BitVector(unsigned size, const Integer& val)
-      : d_size(size), d_value(val.modByPow2(size))
-  {
-  }
+  BitVector(unsigned size, const Integer& val);
 
-  BitVector(unsigned size = 0) : d_size(size), d_value(0) {}
+  /** Constructs the bit-vector of the given size whose value is zero. */
+  BitVector(unsigned size = 0);
 
   /**
    * BitVector constructor using a 32-bit unsigned integer for the value.
@@ -34,10 +40,7 @@ class BitVector
    * platforms (long is 32-bit when compiling 64-bit binaries on
    * Windows but 64-bit on Linux) and to prevent ambiguous overloads.
    */
-  BitVector(unsigned size, uint32_t z) : d_size(size), d_value(z)
-  {
-    d_value = d_value.modByPow2(size);
-  }
+  BitVector(unsigned size, uint32_t z);
 
   /**
    * BitVector constructor using a 64-bit unsigned integer for the value.
@@ -46,15 +49,13 @@ class BitVector
    * platforms (long is 32-bit when compiling 64-bit binaries on
    * Windows but 64-bit on Linux) and to prevent ambiguous overloads.
    */
-  BitVector(unsigned size, uint64_t z) : d_size(size), d_value(z)
-  {
-    d_value = d_value.modByPow2(size);
-  }
+  BitVector(unsigned size, uint64_t z);
 
-  BitVector(unsigned size, const BitVector& q)
-      : d_size(size), d_value(q.d_value)
-  {
-  }
+  /**
+   * Constructs the bit-vector of the given size whose value is the value of
+   * q modulo 2^size.
+   */
+  BitVector(unsigned size, const BitVector& q);
 
   /**
    * BitVector constructor.
@@ -72,20 +73,23 @@ class BitVector
    */
   BitVector(const std::string& num, uint32_t base = 2);
 
+  BitVector(const BitVector& x);
+  BitVector(BitVector&& x) = default;
+
   ~BitVector() {}
 
-  BitVector& operator=(const BitVector& x)
-  {
-    if (this == &x) return *this;
-    d_size = x.d_size;
-    d_value = x.d_value;
-    return *this;
-  }
+  BitVector& operator=(const BitVector& x);
+  BitVector& operator=(BitVector&& x) = default;
+
+  /** Return true if this bit-vector is stored in a single machine word. */
+  bool isSmall() const { return d_big == nullptr; }
+  /** Return the value of this bit-vector, assuming isSmall() is true. */
+  uint64_t getWord() const { return d_word; }
 
   /* Get size (bit-width). */
   unsigned getSize() const;
   /* Get value. */
-  const Integer& getValue() const;
+  Integer getValue() const;
 
   /* Return value. */
   Integer toInteger() const;
@@ -119,15 +123,33 @@ class BitVector
    * (this % y), otherwise.  */
   BitVector unsignedRemTotal(const BitVector& y) const;
 
+  /* Return true if the value of this is greater than the value of y. */
+  bool unsignedGreaterThan(const BitVector& y) const;
+
  private:
+  /** Return the mask for the bits of a bit-vector of the given size <= 64. */
+  static uint64_t mask(unsigned size)
+  {
+    return size >= 64 ? ~uint64_t(0) : ((uint64_t(1) << size) - 1);
+  }
+  /** Return the Integer whose value is w */
+  static Integer wordToInteger(uint64_t w);
+  /** Return the word whose value is val, where 0 <= val < 2^64 */
+  static uint64_t integerToWord(const Integer& val);
+  /** Set the value of this bit-vector to val modulo 2^d_size. */
+  void setValue(const Integer& val);
   /**
    * Class invariants:
-   *  - no overflows: 2^d_size < d_value
-   *  - no negative numbers: d_value >= 0
+   *  - d_big is non-null if and only if d_size > 64,
+   *  - no overflows: the value is less than 2^d_size,
+   *  - no negative numbers: the value is >= 0.
    */
 
   unsigned d_size;
-  Integer d_value;
+  /** The value of this bit-vector, if d_big is null. */
+  uint64_t d_word;
+  /** The value of this bit-vector, if its size is greater than 64. */
+  std::unique_ptr<Integer> d_big;
 
 }; /* class BitVector */
 
@@ -8,6 +8,9 @@
  ******************************************************************************/
 #include "util/filesystem.h"
 
+#include <limits.h>
+#include <stdlib.h>
+
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -185,6 +188,22 @@ void Filepath::makeCanonical()
 #endif
 }
 
+Filepath Filepath::getRealPath() const
+{
+#ifndef USE_CPP_FILESYSTEM
+  char buf[PATH_MAX];
+  if (realpath(rawPath.c_str(), buf) == nullptr)
+  {
+    return *this;
+  }
+  return Filepath(std::string(buf));
+#else
+  std::error_code ec;
+  std::filesystem::path p = std::filesystem::canonical(rawPath, ec);
+  return ec ? *this : Filepath(p);
+#endif
+}
+
 Filepath Filepath::parentPath() const
 {
 #ifndef USE_CPP_FILESYSTEM
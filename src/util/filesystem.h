@@ -73,6 +73,13 @@ class Filepath
    */
   void makeCanonical();
 
+  /**
+   * @return The absolute path of the file this path points to, with symbolic
+   * links, "." and ".." resolved.  If the file does not exist, this returns a
+   * copy of the current path.
+   */
+  Filepath getRealPath() const;
+
   /**
    * @return The current path, but with the filename cut off.
    */
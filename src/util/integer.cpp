@@ -17,70 +17,212 @@ using namespace std;
 
 namespace ethos {
 
-Integer::Integer(const std::string& s, unsigned base)
-  : d_value(s, base)
-{}
+Integer::Integer(const mpz_class& val) : d_small(0) { setValue(val); }
+
+Integer::Integer(const std::string& s, unsigned base) : d_small(0)
+{
+  // parse decimal strings that fit into 64 bits without using GMP
+  size_t start = (!s.empty() && s[0] == '-') ? 1 : 0;
+  size_t ndigits = s.size() - start;
+  if (base == 10 && ndigits > 0 && ndigits <= 18
+      && s.find_first_not_of("0123456789", start) == std::string::npos)
+  {
+    int64_t v = 0;
+    for (size_t i = start, n = s.size(); i < n; i++)
+    {
+      v = v * 10 + (s[i] - '0');
+    }
+    d_small = start == 1 ? -v : v;
+    return;
+  }
+  setValue(mpz_class(s, base));
+}
+
+Integer::Integer(const Integer& q) : d_small(q.d_small)
+{
+  if (q.d_big != nullptr)
+  {
+    d_big.reset(new mpz_class(*q.d_big));
+  }
+}
 
 Integer& Integer::operator=(const Integer& x)
 {
   if (this == &x) return *this;
-  d_value = x.d_value;
+  d_small = x.d_small;
+  if (x.d_big == nullptr)
+  {
+    d_big.reset();
+  }
+  else
+  {
+    d_big.reset(new mpz_class(*x.d_big));
+  }
   return *this;
 }
 
+mpz_class Integer::getValue() const
+{
+  if (d_big != nullptr)
+  {
+    return *d_big;
+  }
+  mpz_class ret;
+  if (d_small >= std::numeric_limits<long>::min()
+      && d_small <= std::numeric_limits<long>::max())
+  {
+    ret = static_cast<long>(d_small);
+  }
+  else
+  {
+    // long is smaller than 64 bits
+    ret = std::to_string(d_small);
+  }
+  return ret;
+}
+
+void Integer::setValue(const mpz_class& val)
+{
+  if (val.fits_slong_p() && sizeof(long) >= sizeof(int64_t))
+  {
+    d_small = val.get_si();
+    d_big.reset();
+  }
+  else if (mpz_sizeinbase(val.get_mpz_t(), 2) < 64)
+  {
+    d_small = std::stoll(val.get_str());
+    d_big.reset();
+  }
+  else
+  {
+    d_small = 0;
+    d_big.reset(new mpz_class(val));
+  }
+}
+
 bool Integer::operator==(const Integer& y) const
 {
-  return d_value == y.d_value;
+  if (d_big == nullptr || y.d_big == nullptr)
+  {
+    // since the representation is canonical, small integers are never equal
+    // to big integers
+    return d_big == y.d_big && d_small == y.d_small;
+  }
+  return *d_big == *y.d_big;
 }
 
-bool Integer::operator>(const Integer& y) const { return d_value > y.d_value; }
+bool Integer::operator>(const Integer& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return d_small > y.d_small;
+  }
+  return getValue() > y.getValue();
+}
 
-bool Integer::operator>=(const Integer& y) const { return d_value >= y.d_value; }
+bool Integer::operator>=(const Integer& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return d_small >= y.d_small;
+  }
+  return getValue() >= y.getValue();
+}
 
-Integer Integer::operator-() const { return Integer(-(d_value)); }
+Integer Integer::operator-() const
+{
+  if (d_big == nullptr && d_small != std::numeric_limits<int64_t>::min())
+  {
+    return Integer(-d_small);
+  }
+  return Integer(-getValue());
+}
 
 Integer Integer::operator+(const Integer& y) const
 {
-  return Integer(d_value + y.d_value);
+  int64_t res;
+  if (d_big == nullptr && y.d_big == nullptr
+      && !__builtin_add_overflow(d_small, y.d_small, &res))
+  {
+    return Integer(res);
+  }
+  return Integer(getValue() + y.getValue());
 }
 
 Integer Integer::operator*(const Integer& y) const
 {
-  return Integer(d_value * y.d_value);
+  int64_t res;
+  if (d_big == nullptr && y.d_big == nullptr
+      && !__builtin_mul_overflow(d_small, y.d_small, &res))
+  {
+    return Integer(res);
+  }
+  return Integer(getValue() * y.getValue());
 }
 
+// Note that bit-wise operations on GMP integers use two's complement, hence
+// they agree with the machine operations on small integers.
+
 Integer Integer::bitwiseOr(const Integer& y) const
 {
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return Integer(d_small | y.d_small);
+  }
   mpz_class result;
-  mpz_ior(result.get_mpz_t(), d_value.get_mpz_t(), y.d_value.get_mpz_t());
+  mpz_class a = getValue();
+  mpz_class b = y.getValue();
+  mpz_ior(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
   return Integer(result);
 }
 
 Integer Integer::bitwiseAnd(const Integer& y) const
 {
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return Integer(d_small & y.d_small);
+  }
   mpz_class result;
-  mpz_and(result.get_mpz_t(), d_value.get_mpz_t(), y.d_value.get_mpz_t());
+  mpz_class a = getValue();
+  mpz_class b = y.getValue();
+  mpz_and(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
   return Integer(result);
 }
 
 Integer Integer::bitwiseXor(const Integer& y) const
 {
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    return Integer(d_small ^ y.d_small);
+  }
   mpz_class result;
-  mpz_xor(result.get_mpz_t(), d_value.get_mpz_t(), y.d_value.get_mpz_t());
+  mpz_class a = getValue();
+  mpz_class b = y.getValue();
+  mpz_xor(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
   return Integer(result);
 }
 
 Integer Integer::bitwiseNot() const
 {
+  if (d_big == nullptr)
+  {
+    return Integer(~d_small);
+  }
   mpz_class result;
-  mpz_com(result.get_mpz_t(), d_value.get_mpz_t());
+  mpz_com(result.get_mpz_t(), d_big->get_mpz_t());
   return Integer(result);
 }
 
 Integer Integer::multiplyByPow2(uint32_t pow) const
 {
+  if (d_big == nullptr && pow < 62 && d_small >= 0
+      && d_small < (int64_t(1) << (62 - pow)))
+  {
+    return Integer(d_small << pow);
+  }
   mpz_class result;
-  mpz_mul_2exp(result.get_mpz_t(), d_value.get_mpz_t(), pow);
+  mpz_class a = getValue();
+  mpz_mul_2exp(result.get_mpz_t(), a.get_mpz_t(), pow);
   return Integer(result);
 }
 
@@ -88,7 +230,7 @@ Integer Integer::oneExtend(uint32_t size, uint32_t amount) const
 {
   // check that the size is accurate
   //Assert((*this) < Integer(1).multiplyByPow2(size));
-  mpz_class res = d_value;
+  mpz_class res = getValue();
 
   for (unsigned i = size; i < size + amount; ++i)
   {
@@ -98,37 +240,85 @@ Integer Integer::oneExtend(uint32_t size, uint32_t amount) const
   return Integer(res);
 }
 
-bool Integer::fitsUnsignedInt() const { return d_value.fits_uint_p(); }
+bool Integer::fitsUnsignedInt() const
+{
+  return d_big == nullptr && d_small >= 0
+         && d_small <= std::numeric_limits<unsigned int>::max();
+}
 
 uint32_t Integer::toUnsignedInt() const
 {
-  return mpz_get_ui(d_value.get_mpz_t());
+  if (d_big == nullptr)
+  {
+    return static_cast<uint32_t>(d_small);
+  }
+  return mpz_get_ui(d_big->get_mpz_t());
 }
 
 Integer Integer::extractBitRange(uint32_t bitCount, uint32_t low) const
 {
   // bitCount = high-low+1
   uint32_t high = low + bitCount - 1;
+  if (d_big == nullptr && high < 63 && d_small >= 0)
+  {
+    uint64_t mask = (uint64_t(1) << bitCount) - 1;
+    return Integer(static_cast<int64_t>((d_small >> low) & mask));
+  }
   //- Function: void mpz_fdiv_r_2exp (mpz_t r, mpz_t n, mp_bitcnt_t b)
   mpz_class rem, div;
-  mpz_fdiv_r_2exp(rem.get_mpz_t(), d_value.get_mpz_t(), high + 1);
+  mpz_class a = getValue();
+  mpz_fdiv_r_2exp(rem.get_mpz_t(), a.get_mpz_t(), high + 1);
   mpz_fdiv_q_2exp(div.get_mpz_t(), rem.get_mpz_t(), low);
 
   return Integer(div);
 }
 
+/**
+ * Returns true if x / y is defined and does not overflow. If so, q and r are
+ * set to the truncated quotient and remainder of x / y.
+ */
+static bool smallTruncDivide(int64_t x, int64_t y, int64_t& q, int64_t& r)
+{
+  if (y == 0 || (x == std::numeric_limits<int64_t>::min() && y == -1))
+  {
+    return false;
+  }
+  q = x / y;
+  r = x % y;
+  return true;
+}
+
 Integer Integer::floorDivideQuotient(const Integer& y) const
 {
-  mpz_class q;
-  mpz_fdiv_q(q.get_mpz_t(), d_value.get_mpz_t(), y.d_value.get_mpz_t());
-  return Integer(q);
+  int64_t q, r;
+  if (d_big == nullptr && y.d_big == nullptr
+      && smallTruncDivide(d_small, y.d_small, q, r))
+  {
+    // round towards negative infinity
+    return Integer((r != 0 && ((r < 0) != (y.d_small < 0))) ? q - 1 : q);
+  }
+  mpz_class res;
+  mpz_class a = getValue();
+  mpz_class b = y.getValue();
+  mpz_fdiv_q(res.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+  return Integer(res);
 }
 
 Integer Integer::floorDivideRemainder(const Integer& y) const
 {
-  mpz_class r;
-  mpz_fdiv_r(r.get_mpz_t(), d_value.get_mpz_t(), y.d_value.get_mpz_t());
-  return Integer(r);
+  int64_t q, r;
+  if (d_big == nullptr && y.d_big == nullptr
+      && smallTruncDivide(d_small, y.d_small, q, r))
+  {
+    // the remainder has the sign of the divisor
+    return Integer((r != 0 && ((r < 0) != (y.d_small < 0))) ? r + y.d_small
+                                                          : r);
+  }
+  mpz_class res;
+  mpz_class a = getValue();
+  mpz_class b = y.getValue();
+  mpz_fdiv_r(res.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+  return Integer(res);
 }
 
 void Integer::euclidianQR(Integer& q,
@@ -136,11 +326,36 @@ void Integer::euclidianQR(Integer& q,
                           const Integer& x,
                           const Integer& y)
 {
+  int64_t sq, sr;
+  if (x.d_big == nullptr && y.d_big == nullptr
+      && smallTruncDivide(x.d_small, y.d_small, sq, sr))
+  {
+    // the remainder is non-negative, which requires fixing the truncated
+    // division if x is negative. This does not overflow since |sr| < |y|.
+    if (sr < 0)
+    {
+      if (y.d_small > 0)
+      {
+        sq = sq - 1;
+        sr = sr + y.d_small;
+      }
+      else
+      {
+        sq = sq + 1;
+        sr = sr - y.d_small;
+      }
+    }
+    q = Integer(sq);
+    r = Integer(sr);
+    return;
+  }
   // compute the floor and then fix the value up if needed.
-  mpz_fdiv_qr(q.d_value.get_mpz_t(),
-              r.d_value.get_mpz_t(),
-              x.d_value.get_mpz_t(),
-              y.d_value.get_mpz_t());
+  mpz_class mq, mr;
+  mpz_class a = x.getValue();
+  mpz_class b = y.getValue();
+  mpz_fdiv_qr(mq.get_mpz_t(), mr.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+  q = Integer(mq);
+  r = Integer(mr);
 
   if (r.sgn()<0)
   {
@@ -184,26 +399,59 @@ Integer Integer::euclidianDivideRemainder(const Integer& y) const
 
 Integer Integer::modByPow2(uint32_t exp) const
 {
+  if (d_big == nullptr)
+  {
+    if (exp < 63)
+    {
+      // two's complement, hence this is non-negative
+      return Integer(d_small & ((int64_t(1) << exp) - 1));
+    }
+    if (d_small >= 0)
+    {
+      return *this;
+    }
+  }
   mpz_class res;
-  mpz_fdiv_r_2exp(res.get_mpz_t(), d_value.get_mpz_t(), exp);
+  mpz_class a = getValue();
+  mpz_fdiv_r_2exp(res.get_mpz_t(), a.get_mpz_t(), exp);
   return Integer(res);
 }
 
-int Integer::sgn() const { return mpz_sgn(d_value.get_mpz_t()); }
+int Integer::sgn() const
+{
+  if (d_big == nullptr)
+  {
+    return d_small > 0 ? 1 : (d_small < 0 ? -1 : 0);
+  }
+  return mpz_sgn(d_big->get_mpz_t());
+}
 
 Integer Integer::pow(uint32_t exp) const
 {
   mpz_class result;
-  mpz_pow_ui(result.get_mpz_t(), d_value.get_mpz_t(), exp);
+  mpz_class a = getValue();
+  mpz_pow_ui(result.get_mpz_t(), a.get_mpz_t(), exp);
   return Integer(result);
 }
 
-std::string Integer::toString(int base) const { return d_value.get_str(base); }
+std::string Integer::toString(int base) const
+{
+  if (d_big == nullptr && base == 10)
+  {
+    return std::to_string(d_small);
+  }
+  return getValue().get_str(base);
+}
 
 
 size_t Integer::hash() const
 {
-  return gmpHash(d_value.get_mpz_t());
+  if (d_big == nullptr)
+  {
+    uint64_t h = static_cast<uint64_t>(d_small) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+  return gmpHash(d_big->get_mpz_t());
 }
 
 size_t Integer::gmpHash(const mpz_t toHash)
@@ -223,9 +471,15 @@ size_t Integer::length() const
   {
     return 1;
   }
+  else if (d_big == nullptr)
+  {
+    uint64_t a = d_small < 0 ? -static_cast<uint64_t>(d_small)
+                             : static_cast<uint64_t>(d_small);
+    return 64 - __builtin_clzll(a);
+  }
   else
   {
-    return mpz_sizeinbase(d_value.get_mpz_t(), 2);
+    return mpz_sizeinbase(d_big->get_mpz_t(), 2);
   }
 }
 
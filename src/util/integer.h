@@ -12,6 +12,7 @@
 #include <gmpxx.h>
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <cstdint>
 
@@ -19,6 +20,15 @@ namespace ethos {
 
 class Rational;
 
+/**
+ * A multi-precision integer.
+ *
+ * Integers that fit into 64 bits are stored in a machine integer and all
+ * operations on them avoid GMP unless they overflow, in which case the result
+ * is promoted to a GMP integer. The representation is canonical, i.e. an
+ * Integer is stored as a GMP integer if and only if it does not fit into 64
+ * bits.
+ */
 class Integer
 {
   friend class Rational;
@@ -27,10 +37,10 @@ class Integer
   /**
    * Constructs an Integer by copying a GMP C++ primitive.
    */
-  Integer(const mpz_class& val) : d_value(val) {}
+  Integer(const mpz_class& val);
 
   /** Constructs a rational with the value 0. */
-  Integer() : d_value(0) {}
+  Integer() : d_small(0) {}
 
   /**
    * Constructs a Integer from a C string.
@@ -40,17 +50,24 @@ class Integer
    */
   explicit Integer(const std::string& s, unsigned base = 10);
 
-  explicit Integer(unsigned int z) : d_value(z) {}
-  Integer(const Integer& q) : d_value(q.d_value) {}
+  explicit Integer(int64_t z) : d_small(z) {}
+  Integer(const Integer& q);
+  Integer(Integer&& q) = default;
 
   /** Destructor. */
   ~Integer() {}
 
-  /** Returns a copy of d_value to enable public access of GMP data. */
-  const mpz_class& getValue() const { return d_value; }
+  /** Returns a copy of the value of this Integer as a GMP integer. */
+  mpz_class getValue() const;
+
+  /** Return true if this Integer fits into 64 bits. */
+  bool isSmall() const { return d_big == nullptr; }
+  /** Return the value of this Integer, assuming isSmall() is true. */
+  int64_t getSmall() const { return d_small; }
 
   /** Overload copy assignment operator. */
   Integer& operator=(const Integer& x);
+  Integer& operator=(Integer&& x) = default;
 
   /** Overload equality comparison operator. */
   bool operator==(const Integer& y) const;
@@ -156,16 +173,20 @@ class Integer
 
  private:
   /**
-   * Gets a reference to the gmp data that backs up the integer.
+   * Gets the gmp data that backs up the integer.
    * Only accessible to friend classes.
    */
-  const mpz_class& get_mpz() const { return d_value; }
+  mpz_class get_mpz() const { return getValue(); }
+  /** Set this Integer to val, which is stored as small if it fits. */
+  void setValue(const mpz_class& val);
 
+  /** The value of this Integer, if d_big is null. */
+  int64_t d_small;
   /**
-   * The value of the rational is stored in a C++ GMP integer class.
-   * Using this instead of mpz_t allows for easier destruction.
+   * The value of the integer if it does not fit into 64 bits, stored in a
+   * C++ GMP integer class.
    */
-  mpz_class d_value;
+  std::unique_ptr<mpz_class> d_big;
 }; /* class Integer */
 
 
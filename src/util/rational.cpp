@@ -11,6 +11,8 @@
 #include <string>
 #include <iostream>
 #include <gmpxx.h>
+#include <limits>
+#include <numeric>
 
 #include "rational.h"
 
@@ -42,9 +44,261 @@ Rational Rational::fromDecimal(const std::string& dec) {
   }
 }
 
-bool Rational::isIntegral() const { return mpz_cmp_ui(d_value.get_den_mpz_t(), 1) == 0; }
+Rational::Rational(const mpq_class& val) : d_num(0), d_den(1)
+{
+  setValue(val);
+}
+
+Rational::Rational(const std::string& s, unsigned base) : d_num(0), d_den(1)
+{
+  mpq_class val(s, base);
+  val.canonicalize();
+  setValue(val);
+}
+
+Rational::Rational(const Rational& q) : d_num(q.d_num), d_den(q.d_den)
+{
+  if (q.d_big != nullptr)
+  {
+    d_big.reset(new mpq_class(*q.d_big));
+  }
+}
+
+Rational::Rational(const Integer& n, const Integer& d) : d_num(0), d_den(1)
+{
+  if (n.isSmall() && d.isSmall() && d.getSmall() != 0
+      && setSmall(n.getSmall(), d.getSmall()))
+  {
+    return;
+  }
+  mpq_class val(n.get_mpz(), d.get_mpz());
+  val.canonicalize();
+  setValue(val);
+}
+
+Rational::Rational(const Integer& n) : d_num(0), d_den(1)
+{
+  if (n.isSmall())
+  {
+    d_num = n.getSmall();
+    return;
+  }
+  setValue(mpq_class(n.get_mpz()));
+}
+
+Rational& Rational::operator=(const Rational& x)
+{
+  if (this == &x) return *this;
+  d_num = x.d_num;
+  d_den = x.d_den;
+  if (x.d_big == nullptr)
+  {
+    d_big.reset();
+  }
+  else
+  {
+    d_big.reset(new mpq_class(*x.d_big));
+  }
+  return *this;
+}
+
+mpq_class Rational::getValue() const
+{
+  if (d_big != nullptr)
+  {
+    return *d_big;
+  }
+  // already in canonical form
+  return mpq_class(Integer(d_num).getValue(), Integer(d_den).getValue());
+}
+
+void Rational::setValue(const mpq_class& val)
+{
+  Integer n(val.get_num());
+  Integer d(val.get_den());
+  if (n.isSmall() && d.isSmall())
+  {
+    d_num = n.getSmall();
+    d_den = d.getSmall();
+    d_big.reset();
+  }
+  else
+  {
+    d_num = 0;
+    d_den = 1;
+    d_big.reset(new mpq_class(val));
+  }
+}
+
+bool Rational::setSmall(int64_t n, int64_t d)
+{
+  static const int64_t minVal = std::numeric_limits<int64_t>::min();
+  // the absolute values must be representable
+  if (n == minVal || d == minVal)
+  {
+    return false;
+  }
+  if (d < 0)
+  {
+    n = -n;
+    d = -d;
+  }
+  int64_t g = std::gcd(n, d);
+  d_num = n / g;
+  d_den = d / g;
+  d_big.reset();
+  return true;
+}
+
+int Rational::sgn() const
+{
+  if (d_big == nullptr)
+  {
+    return d_num > 0 ? 1 : (d_num < 0 ? -1 : 0);
+  }
+  return mpq_sgn(d_big->get_mpq_t());
+}
 
-std::string Rational::toString(int base) const { return d_value.get_str(base); }
+Integer Rational::floor() const
+{
+  if (d_big == nullptr)
+  {
+    // the denominator is positive, round towards negative infinity
+    int64_t q = d_num / d_den;
+    return Integer((d_num % d_den != 0 && d_num < 0) ? q - 1 : q);
+  }
+  mpz_class q;
+  mpz_fdiv_q(q.get_mpz_t(), d_big->get_num_mpz_t(), d_big->get_den_mpz_t());
+  return Integer(q);
+}
+
+Rational Rational::operator-() const
+{
+  if (d_big == nullptr && d_num != std::numeric_limits<int64_t>::min())
+  {
+    Rational ret;
+    ret.d_num = -d_num;
+    ret.d_den = d_den;
+    return ret;
+  }
+  return Rational(-getValue());
+}
+
+bool Rational::operator==(const Rational& y) const
+{
+  if (d_big == nullptr || y.d_big == nullptr)
+  {
+    // since the representation is canonical, small rationals are never equal
+    // to big rationals
+    return d_big == y.d_big && d_num == y.d_num && d_den == y.d_den;
+  }
+  return *d_big == *y.d_big;
+}
+
+Rational Rational::operator+(const Rational& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    int64_t n1, n2, n, d;
+    Rational ret;
+    if (d_den == y.d_den)
+    {
+      if (!__builtin_add_overflow(d_num, y.d_num, &n)
+          && ret.setSmall(n, d_den))
+      {
+        return ret;
+      }
+    }
+    else if (!__builtin_mul_overflow(d_num, y.d_den, &n1)
+             && !__builtin_mul_overflow(y.d_num, d_den, &n2)
+             && !__builtin_add_overflow(n1, n2, &n)
+             && !__builtin_mul_overflow(d_den, y.d_den, &d)
+             && ret.setSmall(n, d))
+    {
+      return ret;
+    }
+  }
+  return Rational(getValue() + y.getValue());
+}
+
+Rational Rational::operator*(const Rational& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    int64_t n, d;
+    Rational ret;
+    if (!__builtin_mul_overflow(d_num, y.d_num, &n)
+        && !__builtin_mul_overflow(d_den, y.d_den, &d) && ret.setSmall(n, d))
+    {
+      return ret;
+    }
+  }
+  return Rational(getValue() * y.getValue());
+}
+
+Rational Rational::operator/(const Rational& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr && y.d_num != 0)
+  {
+    int64_t n, d;
+    Rational ret;
+    if (!__builtin_mul_overflow(d_num, y.d_den, &n)
+        && !__builtin_mul_overflow(d_den, y.d_num, &d) && ret.setSmall(n, d))
+    {
+      return ret;
+    }
+  }
+  return Rational(getValue() / y.getValue());
+}
+
+bool Rational::operator>(const Rational& y) const
+{
+  if (d_big == nullptr && y.d_big == nullptr)
+  {
+    // since denominators are positive, compare the cross products
+    int64_t n1, n2;
+    if (!__builtin_mul_overflow(d_num, y.d_den, &n1)
+        && !__builtin_mul_overflow(y.d_num, d_den, &n2))
+    {
+      return n1 > n2;
+    }
+  }
+  return getValue() > y.getValue();
+}
+
+bool Rational::isIntegral() const
+{
+  if (d_big == nullptr)
+  {
+    return d_den == 1;
+  }
+  return mpz_cmp_ui(d_big->get_den_mpz_t(), 1) == 0;
+}
+
+std::string Rational::toString(int base) const
+{
+  if (d_big == nullptr && base == 10)
+  {
+    std::string ret = std::to_string(d_num);
+    if (d_den != 1)
+    {
+      ret += "/" + std::to_string(d_den);
+    }
+    return ret;
+  }
+  return getValue().get_str(base);
+}
+
+size_t Rational::hash() const
+{
+  if (d_big == nullptr)
+  {
+    return Integer(d_num).hash() ^ (Integer(d_den).hash() * 31);
+  }
+  size_t numeratorHash = Integer::gmpHash(d_big->get_num_mpz_t());
+  size_t denominatorHash = Integer::gmpHash(d_big->get_den_mpz_t());
+  return numeratorHash ^ denominatorHash;
+}
 std::string Rational::toStringDecimal() const
 {
   // NOTE: we simply print as a rational for now, due to limitations in
@@ -11,6 +11,7 @@
 
 #include <gmp.h>
 
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -26,6 +27,10 @@ namespace ethos {
  * is 1.  (This is referred to as referred to as canonical form in GMP's
  * literature.) A consequence is that that the numerator and denominator may be
  * different than the values used to construct the Rational.
+ *
+ * Similar to Integer, rationals whose numerator and denominator fit into 64
+ * bits are stored as a pair of machine integers, and are promoted to a GMP
+ * rational only if an operation overflows.
  */
 class Rational
 {
@@ -36,7 +41,7 @@ class Rational
    * Assumes that the value is in canonical form, and thus does not
    * have to call canonicalize() on the value.
    */
-  Rational(const mpq_class& val) : d_value(val) {}
+  Rational(const mpq_class& val);
 
   /**
    * Creates a rational from a decimal string (e.g., <code>"1.5"</code>).
@@ -47,63 +52,36 @@ class Rational
   static Rational fromDecimal(const std::string& dec);
 
   /** Constructs a rational with the value 0/1. */
-  Rational() : d_value(0) { d_value.canonicalize(); }
+  Rational() : d_num(0), d_den(1) {}
 
-  Rational(const std::string& s, unsigned base = 10) : d_value(s, base)
-  {
-    d_value.canonicalize();
-  }
+  Rational(const std::string& s, unsigned base = 10);
 
   /**
    * Creates a Rational from another Rational, q, by performing a deep copy.
    */
-  Rational(const Rational& q) : d_value(q.d_value) { d_value.canonicalize(); }
-
-  Rational(const Integer& n, const Integer& d)
-      : d_value(n.get_mpz(), d.get_mpz())
-  {
-    d_value.canonicalize();
-  }
-  Rational(const Integer& n) : d_value(n.get_mpz()) { d_value.canonicalize(); }
+  Rational(const Rational& q);
+  Rational(Rational&& q) = default;
+
+  Rational(const Integer& n, const Integer& d);
+  explicit Rational(const Integer& n);
   ~Rational() {}
 
-  int sgn() const { return mpq_sgn(d_value.get_mpq_t()); }
-
-  Integer floor() const
-  {
-    mpz_class q;
-    mpz_fdiv_q(q.get_mpz_t(), d_value.get_num_mpz_t(), d_value.get_den_mpz_t());
-    return Integer(q);
-  }
-
-  Rational& operator=(const Rational& x)
-  {
-    if (this == &x) return *this;
-    d_value = x.d_value;
-    return *this;
-  }
-
-  Rational operator-() const { return Rational(-(d_value)); }
-
-  bool operator==(const Rational& y) const { return d_value == y.d_value; }
-
-  Rational operator+(const Rational& y) const
-  {
-    return Rational(d_value + y.d_value);
-  }
-
-  Rational operator*(const Rational& y) const
-  {
-    return Rational(d_value * y.d_value);
-  }
-  Rational operator/(const Rational& y) const
-  {
-    return Rational(d_value / y.d_value);
-  }
-  bool operator>(const Rational& y) const
-  {
-    return d_value > y.d_value;
-  }
+  int sgn() const;
+
+  Integer floor() const;
+
+  Rational& operator=(const Rational& x);
+  Rational& operator=(Rational&& x) = default;
+
+  Rational operator-() const;
+
+  bool operator==(const Rational& y) const;
+
+  Rational operator+(const Rational& y) const;
+
+  Rational operator*(const Rational& y) const;
+  Rational operator/(const Rational& y) const;
+  bool operator>(const Rational& y) const;
 
   bool isIntegral() const;
 
@@ -117,18 +95,26 @@ class Rational
    * Computes the hash of the rational from hashes of the numerator and the
    * denominator.
    */
-  size_t hash() const
-  {
-    size_t numeratorHash = Integer::gmpHash(d_value.get_num_mpz_t());
-    size_t denominatorHash = Integer::gmpHash(d_value.get_den_mpz_t());
-    return numeratorHash ^ denominatorHash;
-  }
+  size_t hash() const;
  private:
+  /** Returns a copy of the value of this rational as a GMP rational. */
+  mpq_class getValue() const;
+  /** Set this rational to val, which is in canonical form. */
+  void setValue(const mpq_class& val);
+  /**
+   * Set this rational to the canonical form of n/d, where d is non-zero.
+   * Returns false if this requires an overflow, in which case this rational
+   * is unchanged.
+   */
+  bool setSmall(int64_t n, int64_t d);
+  /** The numerator and (positive) denominator, if d_big is null. */
+  int64_t d_num;
+  int64_t d_den;
   /**
-   * Stores the value of the rational is stored in a C++ GMP rational class.
-   * Using this instead of mpq_t allows for easier destruction.
+   * Stores the value of the rational is stored in a C++ GMP rational class,
+   * if its numerator or denominator does not fit into 64 bits.
    */
-  mpq_class d_value;
+  std::unique_ptr<mpq_class> d_big;
 
 }; /* class Rational */
 
@@ -21,34 +21,80 @@ namespace ethos {
 
 //static_assert(std::UCHAR_MAX == 255, "Unsigned char is assumed to have 256 values.");
 
-String::String(const std::vector<unsigned> &s) : d_str(s)
+String::String(const std::vector<unsigned> &s) : d_wide(false)
 {
 #ifdef EO_ASSERTIONS
-  for (unsigned u : d_str)
+  for (unsigned u : s)
   {
     Assert(u < num_codes());
   }
 #endif
+  setCodePoints(s);
 }
 
-int String::cmp(const String &y) const {
-  if (size() != y.size()) {
-    return size() < y.size() ? -1 : 1;
+void String::setCodePoints(const std::vector<unsigned>& vec)
+{
+  d_wide = false;
+  for (unsigned u : vec)
+  {
+    if (u > 255)
+    {
+      d_wide = true;
+      break;
+    }
   }
-  for (unsigned int i = 0; i < size(); ++i) {
-    if (d_str[i] != y.d_str[i]) {
-      unsigned cp = d_str[i];
-      unsigned cpy = y.d_str[i];
-      return cp < cpy ? -1 : 1;
+  if (d_wide)
+  {
+    d_data.resize(4 * vec.size());
+    for (size_t i = 0, n = vec.size(); i < n; i++)
+    {
+      uint32_t c = vec[i];
+      std::memcpy(&d_data[4 * i], &c, 4);
     }
+    return;
+  }
+  d_data.assign(vec.begin(), vec.end());
+}
+
+std::vector<unsigned> String::getVec() const
+{
+  if (!d_wide)
+  {
+    return std::vector<unsigned>(d_data.begin(), d_data.end());
+  }
+  std::vector<unsigned> vec(size());
+  for (size_t i = 0, n = vec.size(); i < n; i++)
+  {
+    vec[i] = getChar(i);
+  }
+  return vec;
+}
+
+size_t String::hash() const
+{
+  std::size_t seed = size();
+  for (size_t i = 0, n = size(); i < n; i++)
+  {
+    seed ^= getChar(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
   }
-  return 0;
+  return seed;
 }
 
 String String::concat(const String &other) const
 {
-  std::vector<unsigned int> ret_vec(d_str);
-  ret_vec.insert(ret_vec.end(), other.d_str.begin(), other.d_str.end());
+  if (d_wide == other.d_wide)
+  {
+    String ret;
+    ret.d_wide = d_wide;
+    ret.d_data.reserve(d_data.size() + other.d_data.size());
+    ret.d_data.insert(ret.d_data.end(), d_data.begin(), d_data.end());
+    ret.d_data.insert(
+        ret.d_data.end(), other.d_data.begin(), other.d_data.end());
+    return ret;
+  }
+  std::vector<unsigned int> ret_vec = getVec();
+  std::vector<unsigned int> other_vec = other.getVec();
+  ret_vec.insert(ret_vec.end(), other_vec.begin(), other_vec.end());
   return String(ret_vec);
 }
 
@@ -197,17 +243,18 @@ std::vector<unsigned> String::toInternal(const std::string& s,
 std::string String::toString(bool useEscSequences) const {
   std::stringstream str;
   for (unsigned int i = 0; i < size(); ++i) {
+    unsigned c = getChar(i);
     // we always print backslash as a code point so that it cannot be
     // interpreted as specifying part of a code point, e.g. the string '\' +
     // 'u' + '0' of length three.
-    if (isPrintable(d_str[i]) && d_str[i] != '\\' && !useEscSequences)
+    if (isPrintable(c) && c != '\\' && !useEscSequences)
     {
-      str << static_cast<char>(d_str[i]);
+      str << static_cast<char>(c);
     }
     else
     {
       std::stringstream ss;
-      ss << std::hex << d_str[i];
+      ss << std::hex << c;
       str << "\\u{" << ss.str() << "}";
     }
   }
@@ -222,8 +269,8 @@ bool String::isLeq(const String &y) const
     {
       return false;
     }
-    unsigned ci = d_str[i];
-    unsigned cyi = y.d_str[i];
+    unsigned ci = getChar(i);
+    unsigned cyi = y.getChar(i);
     if (ci > cyi)
     {
       return false;
@@ -241,10 +288,42 @@ std::size_t String::find(const String &y, const std::size_t start) const {
   if (y.size()==0) return start;
   if (size()==0) return std::string::npos;
 
-  std::vector<unsigned>::const_iterator itr = std::search(
-      d_str.begin() + start, d_str.end(), y.d_str.begin(), y.d_str.end());
-  if (itr != d_str.end()) {
-    return itr - d_str.begin();
+  if (!d_wide)
+  {
+    // y has a code point that does not occur in this string
+    if (y.d_wide)
+    {
+      return std::string::npos;
+    }
+    // Search for the first character of y using memchr and compare the
+    // remainder using memcmp, both of which are vectorized by the C library.
+    const uint8_t* begin = d_data.data();
+    const uint8_t* cur = begin + start;
+    const uint8_t* last = begin + (d_data.size() - y.d_data.size());
+    const uint8_t* ydata = y.d_data.data();
+    size_t ysize = y.d_data.size();
+    while (cur <= last)
+    {
+      const void* p = std::memchr(cur, ydata[0], (last - cur) + 1);
+      if (p == nullptr)
+      {
+        return std::string::npos;
+      }
+      cur = static_cast<const uint8_t*>(p);
+      if (std::memcmp(cur + 1, ydata + 1, ysize - 1) == 0)
+      {
+        return cur - begin;
+      }
+      ++cur;
+    }
+    return std::string::npos;
+  }
+  std::vector<unsigned> vec = getVec();
+  std::vector<unsigned> yvec = y.getVec();
+  std::vector<unsigned>::const_iterator itr =
+      std::search(vec.begin() + start, vec.end(), yvec.begin(), yvec.end());
+  if (itr != vec.end()) {
+    return itr - vec.begin();
   }
   return std::string::npos;
 }
@@ -254,10 +333,12 @@ std::size_t String::rfind(const String &y, const std::size_t start) const {
   if (y.size()==0) return start;
   if (size()==0) return std::string::npos;
 
+  std::vector<unsigned> vec = getVec();
+  std::vector<unsigned> yvec = y.getVec();
   std::vector<unsigned>::const_reverse_iterator itr = std::search(
-      d_str.rbegin() + start, d_str.rend(), y.d_str.rbegin(), y.d_str.rend());
-  if (itr != d_str.rend()) {
-    return itr - d_str.rbegin();
+      vec.rbegin() + start, vec.rend(), yvec.rbegin(), yvec.rend());
+  if (itr != vec.rend()) {
+    return itr - vec.rbegin();
   }
   return std::string::npos;
 }
@@ -266,17 +347,19 @@ String String::update(std::size_t i, const String& t) const
 {
   if (i < size())
   {
-    std::vector<unsigned> vec(d_str.begin(), d_str.begin() + i);
+    std::vector<unsigned> svec = getVec();
+    std::vector<unsigned> tvec = t.getVec();
+    std::vector<unsigned> vec(svec.begin(), svec.begin() + i);
     size_t remNum = size() - i;
-    size_t tnum = t.d_str.size();
+    size_t tnum = tvec.size();
     if (tnum >= remNum)
     {
-      vec.insert(vec.end(), t.d_str.begin(), t.d_str.begin() + remNum);
+      vec.insert(vec.end(), tvec.begin(), tvec.begin() + remNum);
     }
     else
     {
-      vec.insert(vec.end(), t.d_str.begin(), t.d_str.end());
-      vec.insert(vec.end(), d_str.begin() + i + tnum, d_str.end());
+      vec.insert(vec.end(), tvec.begin(), tvec.end());
+      vec.insert(vec.end(), svec.begin() + i + tnum, svec.end());
     }
     return String(vec);
   }
@@ -286,11 +369,8 @@ String String::update(std::size_t i, const String& t) const
 String String::replace(const String &s, const String &t) const {
   std::size_t ret = find(s);
   if (ret != std::string::npos) {
-    std::vector<unsigned> vec;
-    vec.insert(vec.begin(), d_str.begin(), d_str.begin() + ret);
-    vec.insert(vec.end(), t.d_str.begin(), t.d_str.end());
-    vec.insert(vec.end(), d_str.begin() + ret + s.size(), d_str.end());
-    return String(vec);
+    return substr(0, ret).concat(t).concat(
+        substr(ret + s.size(), size() - ret - s.size()));
   } else {
     return *this;
   }
@@ -298,18 +378,27 @@ String String::replace(const String &s, const String &t) const {
 
 String String::substr(std::size_t i, std::size_t j) const {
   Assert(i + j <= size());
-  std::vector<unsigned> ret_vec;
-  std::vector<unsigned>::const_iterator itr = d_str.begin() + i;
-  ret_vec.insert(ret_vec.end(), itr, itr + j);
+  if (!d_wide)
+  {
+    String ret;
+    ret.d_data.assign(d_data.begin() + i, d_data.begin() + i + j);
+    return ret;
+  }
+  std::vector<unsigned> ret_vec(j);
+  for (size_t k = 0; k < j; k++)
+  {
+    ret_vec[k] = getChar(i + k);
+  }
+  // the result may fit into one byte per code point
   return String(ret_vec);
 }
 
 bool String::isNumber() const {
-  if (d_str.empty()) {
+  if (d_data.empty()) {
     return false;
   }
-  for (unsigned character : d_str) {
-    if (!isDigit(character))
+  for (size_t i = 0, n = size(); i < n; i++) {
+    if (!isDigit(getChar(i)))
     {
       return false;
     }
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 
 namespace ethos {
 
@@ -37,8 +38,12 @@ class String
   static inline unsigned num_codes() { return 196608; }
   /** constructors for String
    *
-   * Internally, a cvc5::internal::String is represented by a vector of unsigned
-   * integers (d_str) representing the code points of the characters.
+   * Internally, a cvc5::internal::String is represented by a vector of bytes
+   * (d_data) storing the code points of the characters. If all code points
+   * are less than 256, each is stored in a single byte. Otherwise, each is
+   * stored in four bytes. This representation is canonical, i.e. a string is
+   * stored with four bytes per code point if and only if one of its code
+   * points does not fit into a byte.
    *
    * To build a string from a C++ string, we may process escape sequences
    * according to the SMT-LIB standard. In particular, if useEscSequences is
@@ -54,23 +59,20 @@ class String
    * If useEscSequences is false, then the characters of the constructed
    * cvc5::internal::String correspond one-to-one with the input string.
    */
-  String() = default;
+  String() : d_wide(false) {}
   explicit String(const std::string& s, bool useEscSequences = false)
-      : d_str(toInternal(s, useEscSequences))
+      : d_wide(false)
   {
+    setCodePoints(toInternal(s, useEscSequences));
   }
   explicit String(const std::vector<unsigned>& s);
 
-  String& operator=(const String& y) {
-    if (this != &y) {
-      d_str = y.d_str;
-    }
-    return *this;
-  }
-
   String concat(const String& other) const;
 
-  bool operator==(const String& y) const { return cmp(y) == 0; }
+  bool operator==(const String& y) const
+  {
+    return d_wide == y.d_wide && d_data == y.d_data;
+  }
 
   /* toString
    * Converts this string to a std::string.
@@ -87,7 +89,18 @@ class String
   /** is less than or equal to string y */
   bool isLeq(const String& y) const;
   /** Return the length of the string */
-  std::size_t size() const { return d_str.size(); }
+  std::size_t size() const { return d_wide ? d_data.size() / 4 : d_data.size(); }
+  /** Return the code point at index i of this string */
+  unsigned getChar(std::size_t i) const
+  {
+    if (!d_wide)
+    {
+      return d_data[i];
+    }
+    uint32_t c;
+    std::memcpy(&c, &d_data[4 * i], 4);
+    return c;
+  }
 
   /**
    * Return the first position y occurs in this string, or std::string::npos
@@ -114,7 +127,7 @@ class String
    */
   bool isNumber() const;
   /** Get the unsigned representation (code points) of this string */
-  const std::vector<unsigned>& getVec() const { return d_str; }
+  std::vector<unsigned> getVec() const;
   /** is the unsigned a digit?
    *
    * This is true for code points between 48 ('0') and 57 ('9').
@@ -134,18 +147,10 @@ class String
 
   /**
    * Returns the maximum length of string representable by this class.
-   * Corresponds to the maximum size of d_str.
    */
   static size_t maxSize();
   /** Hash function */
-  size_t hash() const
-  {
-    std::size_t seed = d_str.size();
-    for(auto& i : d_str) {
-      seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    }
-    return seed;
-  }
+  size_t hash() const;
  private:
   /**
    * Helper for toInternal: add character ch to vector vec, storing a string in
@@ -162,12 +167,14 @@ class String
                                           bool useEscSequences);
 
   /**
-   * Returns a negative number if *this < y, 0 if *this and y are equal and a
-   * positive number if *this > y.
+   * Set this string to the given code points, which are stored in a single
+   * byte each if they all fit.
    */
-  int cmp(const String& y) const;
-  /** The data */
-  std::vector<unsigned> d_str;
+  void setCodePoints(const std::vector<unsigned>& vec);
+  /** The code points, stored in one byte each if !d_wide, four otherwise */
+  std::vector<uint8_t> d_data;
+  /** Whether some code point of this string does not fit into a byte */
+  bool d_wide;
 };
 
 std::ostream& operator<<(std::ostream& os, const String& s);
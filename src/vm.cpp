@@ -0,0 +1,371 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#include "vm.h"
+
+#include <unordered_set>
+
+#include "base/check.h"
+#include "base/output.h"
+#include "state.h"
+#include "type_checker.h"
+
+namespace ethos {
+
+Vm::Vm(TypeChecker& tc, State& s) : d_tc(tc), d_state(s) {}
+
+Vm::~Vm() {}
+
+void Vm::compileProgram(const Expr& prog)
+{
+  for (size_t i = 0, ncases = prog.getNumChildren(); i < ncases; i++)
+  {
+    // ground bodies are returned as is, hence only the others are compiled
+    ExprValue* body = prog[i][1].getValue();
+    if (!body->isGround())
+    {
+      getCode(body);
+    }
+  }
+}
+
+bool Vm::hasCode(const ExprValue* e) const
+{
+  return d_code.find(e) != d_code.end();
+}
+
+bool Vm::hasCall(ExprValue* e)
+{
+  std::unordered_set<const ExprValue*> visited;
+  std::vector<ExprValue*> visit{e};
+  ExprValue* cur;
+  do
+  {
+    cur = visit.back();
+    visit.pop_back();
+    if (!cur->isEvaluatable() || !visited.insert(cur).second)
+    {
+      continue;
+    }
+    Kind k = cur->getKind();
+    if (k == Kind::APPLY || k == Kind::APPLY_OPAQUE)
+    {
+      return true;
+    }
+    ExprSpan children = cur->getChildren();
+    visit.insert(visit.end(), children.begin(), children.end());
+  } while (!visit.empty());
+  return false;
+}
+
+void Vm::Scope::popTo(size_t n)
+{
+  for (size_t i = n, nadded = d_added.size(); i < nadded; i++)
+  {
+    d_regs.erase(d_added[i]);
+  }
+  d_added.resize(n);
+}
+
+const Vm::Code* Vm::getCode(ExprValue* e)
+{
+  std::unordered_map<const ExprValue*, std::unique_ptr<Code>>::iterator it =
+      d_code.find(e);
+  if (it != d_code.end())
+  {
+    return it->second.get();
+  }
+  Code* code = new Code;
+  compileTerm(e, *code);
+  d_compiled.emplace_back(e);
+  d_code[e].reset(code);
+  return code;
+}
+
+void Vm::compileTerm(ExprValue* e, Code& code)
+{
+  Scope scope;
+  uint32_t r = compile(e, code, scope);
+  emit(code, Op::RETURN, Kind::NONE, 0, r);
+  Trace("vm") << "COMPILE " << Expr(e) << ": " << code.d_instrs.size()
+              << " instructions, " << code.d_nregs << " registers"
+              << std::endl;
+}
+
+uint32_t Vm::compile(ExprValue* e, Code& code, Scope& scope)
+{
+  std::unordered_map<const ExprValue*, uint32_t>::iterator it =
+      scope.d_regs.find(e);
+  if (it != scope.d_regs.end())
+  {
+    return it->second;
+  }
+  Kind k = e->getKind();
+  ExprSpan children = e->getChildren();
+  uint32_t dst;
+  if (!e->isEvaluatable())
+  {
+    dst = code.d_nregs++;
+    Op op = e->isGround() ? Op::CONST
+                          : (k == Kind::PARAM ? Op::PARAM : Op::SUBST);
+    emit(code, op, k, dst, addConst(code, e));
+  }
+  else if (k == Kind::EVAL_IF_THEN_ELSE && children.size() != 3)
+  {
+    // if it is malformed, it does not evaluate
+    dst = code.d_nregs++;
+    emit(code, Op::CONST, k, dst, addConst(code, e));
+  }
+  else if (k == Kind::EVAL_IF_THEN_ELSE)
+  {
+    uint32_t cond = compile(children[0], code, scope);
+    dst = code.d_nregs++;
+    size_t branch = emit(code, Op::BRANCH, k, 0, cond);
+    // the subterms computed in a branch are not available after it
+    size_t nadded = scope.d_added.size();
+    uint32_t tr = compile(children[1], code, scope);
+    scope.popTo(nadded);
+    emit(code, Op::MOVE, k, dst, tr);
+    size_t tjump = emit(code, Op::JUMP, k, 0, 0);
+    code.d_instrs[branch].d_b = static_cast<uint32_t>(code.d_instrs.size());
+    uint32_t er = compile(children[2], code, scope);
+    scope.popTo(nadded);
+    emit(code, Op::MOVE, k, dst, er);
+    size_t ejump = emit(code, Op::JUMP, k, 0, 0);
+    // if the condition is not a Boolean value, both branches are evaluated
+    // and the ite is rebuilt, which we leave to the type checker
+    code.d_instrs[branch].d_c = static_cast<uint32_t>(code.d_instrs.size());
+    emit(code, Op::EVAL, k, dst, addConst(code, e));
+    uint32_t end = static_cast<uint32_t>(code.d_instrs.size());
+    code.d_instrs[tjump].d_b = end;
+    code.d_instrs[ejump].d_b = end;
+  }
+  else
+  {
+    std::vector<uint32_t> cregs;
+    for (ExprValue* c : children)
+    {
+      cregs.push_back(compile(c, code, scope));
+    }
+    uint32_t start = static_cast<uint32_t>(code.d_operands.size());
+    code.d_operands.insert(code.d_operands.end(), cregs.begin(), cregs.end());
+    dst = code.d_nregs++;
+    Op op = Op::BUILD;
+    if (k == Kind::APPLY || k == Kind::APPLY_OPAQUE)
+    {
+      op = Op::CALL;
+    }
+    else if (isLiteralOp(k))
+    {
+      op = Op::LIT_OP;
+    }
+    // the original term is taken if the arguments are unchanged
+    emit(code,
+         op,
+         k,
+         dst,
+         start,
+         static_cast<uint32_t>(cregs.size()),
+         addConst(code, e));
+  }
+  scope.d_regs[e] = dst;
+  scope.d_added.push_back(e);
+  return dst;
+}
+
+size_t Vm::emit(Code& code,
+                Op op,
+                Kind k,
+                uint32_t dst,
+                uint32_t a,
+                uint32_t b,
+                uint32_t c)
+{
+  code.d_instrs.emplace_back(op, k, dst, a, b, c);
+  return code.d_instrs.size() - 1;
+}
+
+uint32_t Vm::addConst(Code& code, ExprValue* e)
+{
+  code.d_consts.emplace_back(e);
+  return static_cast<uint32_t>(code.d_consts.size() - 1);
+}
+
+Expr Vm::evaluate(ExprValue* e, const Ctx& ctx, bool cache)
+{
+  Assert(e != nullptr);
+  std::unique_ptr<Code> tmp;
+  const Code* code;
+  std::unordered_map<const ExprValue*, std::unique_ptr<Code>>::iterator itc =
+      d_code.find(e);
+  if (itc != d_code.end())
+  {
+    code = itc->second.get();
+  }
+  else if (cache)
+  {
+    code = getCode(e);
+  }
+  else
+  {
+    tmp.reset(new Code);
+    compileTerm(e, *tmp);
+    code = tmp.get();
+  }
+  // The applications of programs and oracles we have evaluated during this
+  // call, which ensures that programs that traverse terms recursively perform
+  // a dag traversal. The results that are null are the applications
+  // themselves.
+  std::unordered_map<const ExprValue*, std::pair<Expr, Expr>> calls;
+  std::unordered_map<const ExprValue*, std::pair<Expr, Expr>>::iterator it;
+  std::vector<Expr> regs(code->d_nregs);
+  std::vector<Frame> frames;
+  frames.emplace_back(code, 0, ctx, 0);
+  std::vector<ExprValue*> args;
+  Expr ret;
+  while (true)
+  {
+    Frame& f = frames.back();
+    const Code& fc = *f.d_code;
+    const Instr& in = fc.d_instrs[f.d_pc++];
+    Expr* r = &regs[f.d_base];
+    switch (in.d_op)
+    {
+      case Op::CONST: r[in.d_dst] = fc.d_consts[in.d_a]; break;
+      case Op::PARAM:
+      {
+        const Expr& p = fc.d_consts[in.d_a];
+        Ctx::iterator itp = f.d_ctx.find(p.getValue());
+        r[in.d_dst] = itp == f.d_ctx.end() ? p : Expr(itp->second);
+      }
+      break;
+      case Op::SUBST:
+      {
+        const Expr& t = fc.d_consts[in.d_a];
+        if (f.d_ctx.empty())
+        {
+          r[in.d_dst] = t;
+          break;
+        }
+        Expr s = d_tc.substitute(t.getValue(), f.d_ctx);
+        if (s.isNull())
+        {
+          // a parameter is replaced by a program or oracle
+          s = d_tc.evaluateInternal(t.getValue(), f.d_ctx);
+        }
+        r[in.d_dst] = s;
+      }
+      break;
+      case Op::BUILD:
+      case Op::LIT_OP:
+      case Op::CALL:
+      {
+        const Expr& orig = fc.d_consts[in.d_c];
+        bool changed = false;
+        args.clear();
+        for (uint32_t i = 0; i < in.d_b; i++)
+        {
+          ExprValue* a = r[fc.d_operands[in.d_a + i]].getValue();
+          args.push_back(a);
+          changed = changed || a != (*orig.getValue())[i];
+        }
+        Expr ev;
+        if (in.d_op == Op::LIT_OP)
+        {
+          ev = d_tc.evaluateLiteralOpInternal(in.d_kind, args);
+        }
+        else if (in.d_op == Op::CALL
+                 && (args[0]->getKind() == Kind::PROGRAM_CONST
+                     || args[0]->getKind() == Kind::ORACLE))
+        {
+          Expr app(changed ? d_state.mkExprInternal(in.d_kind, args)
+                           : orig.getValue());
+          it = calls.find(app.getValue());
+          if (it != calls.end())
+          {
+            ev = it->second.second;
+          }
+          else
+          {
+            Expr memoApp;
+            if (!d_tc.findProgramMemo(args, ev, memoApp))
+            {
+              Ctx newCtx;
+              ev = d_tc.evaluateProgramInternal(args, newCtx);
+              if (!ev.isNull() && !ev.isGround() && !newCtx.empty())
+              {
+                // evaluate the body in a new frame
+                const Code* bc = getCode(ev.getValue());
+                size_t base = regs.size();
+                uint32_t dst = in.d_dst;
+                frames.emplace_back(bc, base, newCtx, dst);
+                frames.back().d_app = app;
+                frames.back().d_memoApp = memoApp;
+                regs.resize(base + bc->d_nregs);
+                continue;
+              }
+              d_tc.insertProgramMemo(memoApp, ev);
+            }
+            calls[app.getValue()] = std::pair<Expr, Expr>(app, ev);
+          }
+          r[in.d_dst] = ev.isNull() ? app : ev;
+          break;
+        }
+        if (ev.isNull())
+        {
+          ev = changed ? Expr(d_state.mkExprInternal(in.d_kind, args)) : orig;
+        }
+        r[in.d_dst] = ev;
+      }
+      break;
+      case Op::BRANCH:
+      {
+        ExprValue* c = r[in.d_a].getValue();
+        if (c->getKind() != Kind::BOOLEAN)
+        {
+          f.d_pc = in.d_c;
+        }
+        else if (!c->asLiteral()->d_bool)
+        {
+          f.d_pc = in.d_b;
+        }
+      }
+      break;
+      case Op::MOVE: r[in.d_dst] = r[in.d_a]; break;
+      case Op::JUMP: f.d_pc = in.d_b; break;
+      case Op::EVAL:
+        r[in.d_dst] = d_tc.evaluateInternal(fc.d_consts[in.d_a].getValue(),
+                                            f.d_ctx);
+        break;
+      case Op::RETURN:
+      {
+        ret = r[in.d_a];
+        Trace("vm") << "RETURN " << ret << ", depth=" << frames.size()
+                    << std::endl;
+        if (!f.d_app.isNull())
+        {
+          calls[f.d_app.getValue()] = std::pair<Expr, Expr>(f.d_app, ret);
+          d_tc.insertProgramMemo(f.d_memoApp, ret);
+        }
+        size_t base = f.d_base;
+        uint32_t dst = f.d_ret;
+        frames.pop_back();
+        regs.resize(base);
+        if (frames.empty())
+        {
+          return ret;
+        }
+        regs[frames.back().d_base + dst] = ret;
+      }
+      break;
+    }
+  }
+  return ret;
+}
+
+}  // namespace ethos
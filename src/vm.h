@@ -0,0 +1,189 @@
+/******************************************************************************
+ * This file is part of the ethos project.
+ *
+ * Copyright (c) 2023-2024 by the authors listed in the file AUTHORS
+ * in the top-level source directory and their institutional affiliations.
+ * All rights reserved.  See the file COPYING in the top-level source
+ * directory for licensing information.
+ ******************************************************************************/
+#ifndef VM_H
+#define VM_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "expr.h"
+#include "kind.h"
+
+namespace ethos {
+
+class State;
+class TypeChecker;
+
+/**
+ * A register-based bytecode interpreter for evaluating terms, which is used
+ * for the bodies of programs and for the types of proof rules.
+ *
+ * A term is compiled once into a sequence of instructions, one for each of
+ * its evaluatable subterms, where shared subterms are computed once. The
+ * subterms that are not evaluatable are instantiated by substitution, and
+ * the branches of eo::ite are compiled as jumps so that only the relevant
+ * branch is computed. Applications of programs push a frame onto an
+ * explicit stack, hence deep recursion does not consume the native stack.
+ * As in TypeChecker::evaluate, applications of programs are cached for the
+ * duration of an evaluation, so that programs traversing terms with shared
+ * subterms visit them once.
+ */
+class Vm
+{
+ public:
+  Vm(TypeChecker& tc, State& s);
+  ~Vm();
+  /** Compile the bodies of the cases of the program prog */
+  void compileProgram(const Expr& prog);
+  /** Has e been compiled? */
+  bool hasCode(const ExprValue* e) const;
+  /**
+   * Does e have an evaluatable subterm that is an application, which may be
+   * an application of a program or oracle?
+   */
+  static bool hasCall(ExprValue* e);
+  /**
+   * Evaluate e in the context ctx. This returns the same result as
+   * TypeChecker::evaluate. If e has not been compiled, it is compiled, where
+   * its code is kept for later evaluations if cache is true.
+   */
+  Expr evaluate(ExprValue* e, const Ctx& ctx, bool cache = false);
+
+ private:
+  /** The opcodes */
+  enum class Op : uint8_t
+  {
+    // d_dst := d_consts[d_a]
+    CONST,
+    // d_dst := the value of parameter d_consts[d_a] in the context
+    PARAM,
+    // d_dst := d_consts[d_a] with the context substituted into it
+    SUBST,
+    // d_dst := the term of kind d_kind with children given by the d_b
+    // registers in d_operands starting at d_a
+    BUILD,
+    // as BUILD, where the term is evaluated as a literal operator
+    LIT_OP,
+    // as BUILD for an application, where applications of programs and
+    // oracles are evaluated
+    CALL,
+    // jump to d_b if d_a is false, to d_c if it is not a Boolean value
+    BRANCH,
+    // d_dst := d_a
+    MOVE,
+    // jump to d_b
+    JUMP,
+    // d_dst := d_consts[d_a] evaluated by TypeChecker::evaluate
+    EVAL,
+    // return d_a
+    RETURN
+  };
+  /** An instruction */
+  class Instr
+  {
+   public:
+    Instr(Op op, Kind k, uint32_t dst, uint32_t a, uint32_t b, uint32_t c)
+        : d_op(op), d_kind(k), d_dst(dst), d_a(a), d_b(b), d_c(c)
+    {
+    }
+    Op d_op;
+    Kind d_kind;
+    uint32_t d_dst;
+    uint32_t d_a;
+    uint32_t d_b;
+    uint32_t d_c;
+  };
+  /** The code for a term */
+  class Code
+  {
+   public:
+    Code() : d_nregs(0) {}
+    /** The instructions */
+    std::vector<Instr> d_instrs;
+    /** The registers that are arguments of BUILD, LIT_OP and CALL */
+    std::vector<uint32_t> d_operands;
+    /** The terms referenced by instructions */
+    std::vector<Expr> d_consts;
+    /** The number of registers */
+    uint32_t d_nregs;
+  };
+  /**
+   * The registers of the subterms computed so far while compiling a term.
+   * The subterms computed in a branch of eo::ite are removed once the branch
+   * is compiled, since they are not available after it.
+   */
+  class Scope
+  {
+   public:
+    /** The register of each subterm */
+    std::unordered_map<const ExprValue*, uint32_t> d_regs;
+    /** The subterms in the order they were added to d_regs */
+    std::vector<const ExprValue*> d_added;
+    /** Remove the subterms added after the first n */
+    void popTo(size_t n);
+  };
+  /** A frame of the evaluation stack */
+  class Frame
+  {
+   public:
+    Frame(const Code* code, size_t base, const Ctx& ctx, uint32_t ret)
+        : d_code(code), d_pc(0), d_base(base), d_ctx(ctx), d_ret(ret)
+    {
+    }
+    /** The code being executed */
+    const Code* d_code;
+    /** The index of the next instruction */
+    size_t d_pc;
+    /** The index of the first register of this frame */
+    size_t d_base;
+    /** The context */
+    Ctx d_ctx;
+    /** The register of the caller that is assigned the result */
+    uint32_t d_ret;
+    /** The application of a program whose result this frame computes */
+    Expr d_app;
+    /** The application to store in the memo table of the type checker */
+    Expr d_memoApp;
+  };
+  /** Get the code for e, compiling it if necessary */
+  const Code* getCode(ExprValue* e);
+  /** Compile e into code */
+  void compileTerm(ExprValue* e, Code& code);
+  /**
+   * Compile e into code, returning the register that holds its value. The
+   * scope contains the registers of subterms already computed.
+   */
+  uint32_t compile(ExprValue* e, Code& code, Scope& scope);
+  /** Add an instruction to code, return its index */
+  static size_t emit(Code& code,
+                     Op op,
+                     Kind k,
+                     uint32_t dst,
+                     uint32_t a,
+                     uint32_t b = 0,
+                     uint32_t c = 0);
+  /** Add a term to the constants of code, return its index */
+  static uint32_t addConst(Code& code, ExprValue* e);
+  /** The type checker */
+  TypeChecker& d_tc;
+  /** The state */
+  State& d_state;
+  /** The compiled code, by term */
+  std::unordered_map<const ExprValue*, std::unique_ptr<Code>> d_code;
+  /** The terms that have been compiled, which we hold a reference to */
+  std::vector<Expr> d_compiled;
+  /** The null expression */
+  Expr d_null;
+};
+
+}  // namespace ethos
+
+#endif /* VM_H */